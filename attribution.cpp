@@ -0,0 +1,125 @@
+//
+// Attribution of misses and writebacks to address regions and to the instructions (PCs) that caused them.
+//
+
+#include <algorithm>
+#include "attribution.h"
+
+static const unsigned int ATTRIBUTION_PROBES = 16;
+
+/**
+ * @param capacity number of slots, rounded up to a power of two
+ */
+AttributionTable::AttributionTable(unsigned int capacity) : evictions(0), used(0){
+    unsigned int size = ATTRIBUTION_PROBES;
+    while (size < capacity)
+        size <<= 1;
+    Slot empty = {0, false, {0, 0, 0, 0}, 0};
+    slots.assign(size, empty);
+}
+
+/**
+ * finds the counters of a key, adding it to the table (and replacing another key, whose counters it takes over,
+ * when its window is full)
+ * @param key region or PC
+ * @return the counters of the key
+ */
+AttributionCounts& AttributionTable::at(uint64_t key){
+    // murmur3 finalizer, neighbouring regions must not fill the same window
+    uint64_t hash = key;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    size_t mask = slots.size() - 1;
+    Slot* victim = NULL;
+    for (unsigned int probe = 0; probe < ATTRIBUTION_PROBES; probe++){
+        Slot& slot = slots[(hash + probe) & mask];
+        if (slot.used && slot.key == key)
+            return slot.counts;
+        if (!slot.used){
+            victim = &slot;
+            used++;
+            break;
+        }
+        if (victim == NULL || slot.counts.total() < victim->counts.total())
+            victim = &slot;
+    }
+    if (victim->used){
+        evictions++;
+        victim->error = victim->counts.total();
+    }
+    victim->key = key;
+    victim->used = true;
+    return victim->counts;
+}
+
+bool AttributionTable::byTotal(const Slot& a, const Slot& b){
+    if (a.counts.total() != b.counts.total())
+        return a.counts.total() > b.counts.total();
+    return a.key < b.key;
+}
+
+/**
+ * prints the keys with the most events, one line per key with the bound of its overcount
+ * @param out stream to print to
+ * @param name what the keys are, "Region" or "PC"
+ * @param top number of keys to print
+ */
+void AttributionTable::print(FILE* out, const char* name, unsigned int top) const{
+    vector<Slot> ranked;
+    for (unsigned int i = 0; i < slots.size(); i++){
+        if (slots[i].used)
+            ranked.push_back(slots[i]);
+    }
+    sort(ranked.begin(), ranked.end(), byTotal);
+    fprintf(out, "%s tracked=%u evicted=%llu\n", name, used, evictions);
+    for (unsigned int i = 0; i < ranked.size() && i < top; i++){
+        const AttributionCounts& counts = ranked[i].counts;
+        fprintf(out, "%s 0x%llx L1misses=%llu L2misses=%llu L1writebacks=%llu L2writebacks=%llu error=%llu\n", name,
+                (unsigned long long)ranked[i].key, counts.l1Misses, counts.l2Misses, counts.l1Writebacks,
+                counts.l2Writebacks, ranked[i].error);
+    }
+}
+
+/**
+ * charges an L1 miss to the region of the address and to the current PC
+ * @param address accessed address
+ * @param l2Miss whether the access missed in L2 as well
+ */
+void AccessAttribution::miss(uint64_t address, bool l2Miss){
+    AttributionCounts& region = regions.at(address >> regionBits << regionBits);
+    region.l1Misses++;
+    region.l2Misses += l2Miss;
+    if (hasPC){
+        AttributionCounts& instruction = pcs.at(pc);
+        instruction.l1Misses++;
+        instruction.l2Misses += l2Miss;
+    }
+}
+
+/**
+ * charges a writeback to the region of the evicted block and to the PC of the access that evicted it
+ * @param address address of the evicted block
+ * @param toMemory true for an L2 writeback to memory, false for an L1 writeback to L2
+ */
+void AccessAttribution::writeback(uint64_t address, bool toMemory){
+    AttributionCounts& region = regions.at(address >> regionBits << regionBits);
+    (toMemory ? region.l2Writebacks : region.l1Writebacks)++;
+    if (hasPC){
+        AttributionCounts& instruction = pcs.at(pc);
+        (toMemory ? instruction.l2Writebacks : instruction.l1Writebacks)++;
+    }
+}
+
+/**
+ * prints the regions (and the PCs, when the trace has them) with the most misses and writebacks
+ * @param out stream to print to
+ * @param top number of regions and PCs to print
+ */
+void AccessAttribution::print(FILE* out, unsigned int top) const{
+    regions.print(out, "Region", top);
+    if (hasPC)
+        pcs.print(out, "PC", top);
+}
@@ -0,0 +1,81 @@
+//
+// Attribution of misses and writebacks to address regions and to the instructions (PCs) that caused them.
+//
+
+#ifndef ATTRIBUTION_H
+#define ATTRIBUTION_H
+
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ * the events counted for one region or PC
+ */
+struct AttributionCounts{
+    unsigned long long l1Misses;
+    unsigned long long l2Misses;
+    unsigned long long l1Writebacks;    // dirty L1 evictions written to L2
+    unsigned long long l2Writebacks;    // dirty L2 evictions written to memory
+    unsigned long long total() const{
+        return l1Misses + l2Misses + l1Writebacks + l2Writebacks;
+    }
+};
+
+/**
+ * counters per key in an open addressing table of fixed size.
+ * a key is looked for in a window of slots after its hash (linear probing), and once the window is full the key
+ * with the fewest events in it is replaced, so memory never grows and the heavy hitters stay in the table.
+ * as in Space-Saving, the new key inherits the counters of the key it replaces and keeps their total as the bound
+ * of its overcount, so a key that keeps coming back climbs past the keys that come once instead of restarting at 0.
+ * keys are never deleted otherwise, so a lookup can stop at the first empty slot.
+ */
+class AttributionTable{
+    struct Slot{
+        uint64_t key;
+        bool used;
+        AttributionCounts counts;
+        unsigned long long error;   // events the key inherited, at most that many of its counts are not its own
+    };
+    vector<Slot> slots;
+    unsigned long long evictions;
+    unsigned int used;
+
+    static bool byTotal(const Slot& a, const Slot& b);
+public:
+    explicit AttributionTable(unsigned int capacity);
+    AttributionCounts& at(uint64_t key);
+    unsigned long long getEvictions() const{
+        return evictions;
+    }
+    void print(FILE* out, const char* name, unsigned int top) const;
+};
+
+/**
+ * buckets the misses and writebacks of a cache by address region and by the PC of the access that caused them.
+ * misses are charged to the region of the accessed address, writebacks to the region of the evicted block.
+ */
+class AccessAttribution{
+    const unsigned int regionBits;
+    AttributionTable regions;
+    AttributionTable pcs;
+    uint64_t pc;
+    bool hasPC;
+public:
+    AccessAttribution(unsigned int regionBits, unsigned int capacity) : regionBits(regionBits), regions(capacity),
+                                                                        pcs(capacity), pc(0), hasPC(false){}
+    /**
+     * @param pc instruction address of the next access, 0 if the trace has no PC column
+     */
+    void setPC(uint64_t pc){
+        this->pc = pc;
+        hasPC = hasPC || pc != 0;
+    }
+    void miss(uint64_t address, bool l2Miss);
+    void writeback(uint64_t address, bool toMemory);
+    void print(FILE* out, unsigned int top) const;
+};
+
+#endif // ATTRIBUTION_H
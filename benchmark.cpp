@@ -0,0 +1,205 @@
+//
+// Throughput benchmark of the simulator itself.
+// Synthetic traces are generated in memory and run through Cache::update for a matrix of cache geometries, and every
+// run reports accesses per second, nanoseconds per access and heap allocations per access.
+// Every line has the same fields in the same order so the outputs of two builds can be diffed.
+//
+// Usage: benchmark [-n accesses] [-r repetitions]
+//
+
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "cache.h"
+
+using namespace std;
+
+static atomic<unsigned long long> allocations(0);
+
+// every form counts through operator new and frees through operator delete, none inlined so that no caller
+// pairs a new expression with free()
+__attribute__((noinline)) void* operator new(size_t size){
+    allocations.fetch_add(1, memory_order_relaxed);
+    void* memory = malloc(size ? size : 1);
+    if (memory == NULL)
+        throw bad_alloc();
+    return memory;
+}
+
+__attribute__((noinline)) void* operator new[](size_t size){
+    return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void* memory) noexcept{
+    free(memory);
+}
+
+__attribute__((noinline)) void operator delete[](void* memory) noexcept{
+    operator delete(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, size_t) noexcept{
+    operator delete(memory);
+}
+
+__attribute__((noinline)) void operator delete[](void* memory, size_t) noexcept{
+    operator delete(memory);
+}
+
+/**
+ * splitmix64, so every trace is the same on every machine
+ */
+class Random{
+    uint64_t state;
+public:
+    explicit Random(uint64_t seed) : state(seed){}
+    uint64_t next(){
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+    double uniform(){
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+struct Access{
+    uint32_t address;
+    OPERATION op;
+};
+
+struct Geometry{
+    const char* name;
+    unsigned int bSize;
+    unsigned int l1Size;
+    unsigned int l1Assoc;
+    unsigned int l2Size;
+    unsigned int l2Assoc;
+};
+
+// log2 sizes, as given to cacheSim
+static const Geometry geometries[] = {
+        {"b6-l1s12a0-l2s15a1", 6, 12, 0, 15, 1},
+        {"b5-l1s14a1-l2s17a2", 5, 14, 1, 17, 2},
+        {"b6-l1s15a3-l2s18a4", 6, 15, 3, 18, 4},
+        {"b6-l1s16a4-l2s20a4", 6, 16, 4, 20, 4},
+};
+
+static const unsigned int footprintBlocks = 1u << 16;  // 4MiB of 64 byte blocks, larger than every L2 above
+static const uint32_t base = 0x10000000;
+
+/**
+ * @param random generator used for the operations
+ * @return a write for 30% of the accesses and a read for the rest
+ */
+static OPERATION nextOperation(Random& random){
+    return random.next() % 10 < 3 ? WRITE : READ;
+}
+
+/**
+ * generates a synthetic trace
+ * @param pattern sequential, strided, random, zipfian or pointer-chase
+ * @param count number of accesses
+ * @param trace set to the generated accesses
+ */
+static void generateTrace(const string& pattern, unsigned int count, vector<Access>& trace){
+    Random random(0x5eed);
+    trace.resize(count);
+    if (pattern == "zipfian"){
+        // inverse transform sampling over the cumulative distribution of rank^-0.99
+        vector<double> cdf(footprintBlocks);
+        double sum = 0;
+        for (unsigned int i = 0; i < footprintBlocks; i++)
+            cdf[i] = (sum += pow(i + 1.0, -0.99));
+        // ranks are scattered over the footprint so popular blocks do not share sets
+        vector<uint32_t> blockOfRank(footprintBlocks);
+        for (unsigned int i = 0; i < footprintBlocks; i++)
+            blockOfRank[i] = i;
+        for (unsigned int i = footprintBlocks - 1; i > 0; i--)
+            swap(blockOfRank[i], blockOfRank[random.next() % (i + 1)]);
+        for (unsigned int i = 0; i < count; i++){
+            unsigned int rank = lower_bound(cdf.begin(), cdf.end(), random.uniform() * sum) - cdf.begin();
+            trace[i].address = base + blockOfRank[min(rank, footprintBlocks - 1)] * 64;
+            trace[i].op = nextOperation(random);
+        }
+        return;
+    }
+    vector<uint32_t> successor;
+    uint32_t node = 0;
+    if (pattern == "pointer-chase"){
+        // Sattolo's algorithm gives a single cycle through every block of the footprint
+        successor.resize(footprintBlocks);
+        for (unsigned int i = 0; i < footprintBlocks; i++)
+            successor[i] = i;
+        for (unsigned int i = footprintBlocks - 1; i > 0; i--)
+            swap(successor[i], successor[random.next() % i]);
+    }
+    for (unsigned int i = 0; i < count; i++){
+        uint32_t offset;
+        if (pattern == "sequential")
+            offset = (i * 4) % (footprintBlocks * 64);
+        else if (pattern == "strided")
+            offset = (i * 4160) % (footprintBlocks * 64);  // 65 blocks apart, touching every set
+        else if (pattern == "random")
+            offset = random.next() % (footprintBlocks * 64);
+        else
+            offset = (node = successor[node]) * 64;
+        trace[i].address = base + offset;
+        trace[i].op = nextOperation(random);
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned int count = 200000;
+    unsigned int repetitions = 3;
+    for (int i = 1; i + 1 < argc; i += 2){
+        string s(argv[i]);
+        if (s == "-n")
+            count = atoi(argv[i + 1]);
+        else if (s == "-r")
+            repetitions = atoi(argv[i + 1]);
+    }
+    if (count == 0 || repetitions == 0){
+        fprintf(stderr, "Usage: %s [-n accesses] [-r repetitions]\n", argv[0]);
+        return 1;
+    }
+
+    const char* patterns[] = {"sequential", "strided", "random", "zipfian", "pointer-chase"};
+    vector<Access> trace;
+    for (unsigned int p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++){
+        generateTrace(patterns[p], count, trace);
+        for (unsigned int g = 0; g < sizeof(geometries) / sizeof(geometries[0]); g++){
+            const Geometry& geometry = geometries[g];
+            // the fastest repetition is reported, the others only absorb noise from the machine
+            double best = 0;
+            unsigned long long allocated = 0;
+            double l1Miss = 0, l2Miss = 0;
+            for (unsigned int r = 0; r < repetitions; r++){
+                Cache<uint32_t> cache(100, geometry.bSize, 1, geometry.l1Size, geometry.l1Assoc, 1,
+                                      geometry.l2Size, geometry.l2Assoc, 5);
+                unsigned long long before = allocations.load(memory_order_relaxed);
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                for (unsigned int i = 0; i < count; i++)
+                    cache.update(trace[i].address, trace[i].op);
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                allocated = allocations.load(memory_order_relaxed) - before;
+                if (r == 0 || seconds < best)
+                    best = seconds;
+                l1Miss = cache.getL1MissRate();
+                l2Miss = cache.getL2MissRate();
+            }
+            printf("trace=%-13s geometry=%-18s accesses=%u l1Miss=%.03f l2Miss=%.03f accPerSec=%.0f "
+                   "nsPerAccess=%.1f allocsPerAccess=%.3f\n", patterns[p], geometry.name, count, l1Miss, l2Miss,
+                   count / best, best * 1e9 / count, double(allocated) / count);
+        }
+    }
+    return 0;
+}
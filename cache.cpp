@@ -2,199 +2,234 @@
 // Created by nadav ashkenazi on 15/12/2020.
 //
 
-#include <map>
-#include <math.h>
-#include <vector>
-#include <stdio.h>
-#include <iostream>
-#include "list"
-#include <stdint.h>
-
-using namespace std;
-
-enum HIERARCHY {L1, L2, MEM};
-enum OPERATION {READ, WRITE};
+#include <exception>
+#include <utility>
+#include "cache.h"
 
 /**
- * returns the tag which is the bits from #(blockBits + setBits) until the end  where every bit not
- * used for tag 0;
- * @param address - address to extract tag
- * @param numOfSetBits - number of bit used for deciding set
- * @param bSize -block size
- * @return the relevant tag
+ * finds the line that holds the block of address
+ * @param address to look for
+ * @param line set to the line when the block is there
+ * @return the set that holds the line, NULL if the block is not in the cache hierarchy
  */
-unsigned int getTag(uint32_t address, int numOfSetBits, int bSize){
-    uint32_t mask = 0;
-    for (int i = 0; i < numOfSetBits + bSize; i++){
-        mask = mask << 1;
-        mask += 1;
+template <typename Addr>
+list<Entry<Addr> >* CacheHierarchy<Addr>::locate(Addr address, typename list<Entry<Addr> >::iterator& line){
+    unsigned int ways = isSkewed() ? 1u << lAssoc : 1;     // a skewed level looks at one line in every way
+    for (unsigned int way = 0; way < ways; way++){
+        list<Entry<Addr> >* temp = &L[keyOf(address, way)];
+        for (line = temp->begin(); line != temp->end(); ++line){
+            if ((address >> bSize) == (line->address >> bSize))
+                return temp;
+        }
     }
-    uint32_t res = address & (~mask);
-    return res;
+    return NULL;
 }
 
 /**
- * returns the set which is the bits from #(blockBits) until #(blockBits+setBits) as a 32 bit address where every bit not
- * used for set is 0;
- * @param address -address to extract set from
- * @param numOfSetBits - number of bit used for deciding set
- * @param bSize -block size
- * @return the relevant set
+ * Checks if the data in address is in the cache hierarchy
+ * @param address for check
+ * @return true if the data is inside the cache hierarchy and false otherwise
  */
-unsigned int getSet(uint32_t address, int numOfSetBits, int bSize){
-    uint32_t mask = 0;
-    for (int i = 0; i < numOfSetBits; i++){
-        mask = mask << 1;
-        mask += 1;
-    }
-    for (int i = 0; i <  bSize; i++){
-        mask = mask << 1;
-    }
-    uint32_t res = address & mask;
-    return res;
+template <typename Addr>
+bool CacheHierarchy<Addr>::snoop(Addr address){
+    typename list<Entry<Addr> >::iterator line;
+    return locate(address, line) != NULL;
 }
 
 /**
- * returns the offset which is the bits from the start until #(blockBits) as a 32 bit address where every bit not
- * used for offset is 0;
- * @param address -address to extract set from
- * @param bSize -block size
- * @return the relevant set
+ * adds the block holding address to the cache hierarchy, only the sector of address is valid in a sectored line.
+ * a skewed level puts it in the first way whose set for the block is free
+ * @param address to add to cache
+ * @param way free way of the set to put the line in, -1 for the first free one
  */
-unsigned int getOffset(uint32_t address, int bSize){
-    uint32_t mask = 0;
-
-    for (int i = 0; i < bSize; i++){
-        mask = mask << 1;
-        mask += 1;
+template <typename Addr>
+void CacheHierarchy<Addr>::add(Addr address, int way){
+    Entry<Addr> entry = Entry<Addr>(address, 0, 1);
+    if (!isSkewed()){
+        if (!freeWays.empty()){     // the set is not full, so one of its words has a free way
+            uint64_t* words = &freeWays[(keyOf(address, 0) >> bSize) * wayWords()];
+            if (way < 0){
+                unsigned int word = 0;
+                while (words[word] == 0)
+                    word++;
+                way = word * 64 + __builtin_ctzll(words[word]);
+            }
+            words[way / 64] &= ~(1ull << (way % 64));
+            entry.way = way;
+        }
+        L[keyOf(address, 0)].push_front(entry);
+    } else {
+        unsigned int free = 0;
+        while (free < (1u << lAssoc) && !L[keyOf(address, free)].empty())
+            free++;
+        if (free == (1u << lAssoc))
+            throw std::exception();
+        entry.way = free;
+        L[keyOf(address, entry.way)].push_front(entry);
+        lastUse[keyOf(address, entry.way) >> bSize] = ++useClock;
     }
-    return address & mask;
+    size_t slot = slotOf(entry);
+    if (!sectorMasks.empty())
+        sectorMasks[slot] = sectorOf(address);
+    if (!reusedBits.empty())
+        reusedBits[slot] = 0;
 }
 
 /**
- * a Class that hold the relevant data for an entry inside the cache
- */
-class Entry{
-public:
-    const uint32_t address;
-    bool dirtyBit;
-    bool validBit;
-    Entry(uint32_t address, bool dirtyBit = 0, bool validBit =1) : address(address), dirtyBit(dirtyBit), validBit(validBit){}
-};
-
-
-/**
- * a Class that represents a single hierarchy inside the cache memory such as L1 or L2
+ * updates the cache hierarchies LRU order to reflect that address was used last
+ * @param address most recently used
  */
-class CacheHierarchy{
-public:
-    const unsigned int numOfSetBits;
-    const unsigned int lAssoc;
-    const unsigned int lCyc;
-    const unsigned int bSize;
-    map<int,list<Entry> > L;
-    CacheHierarchy(unsigned int lSize = 0, unsigned int lAssoc =0, unsigned int lCyc = 0, unsigned int bSize =0) :
-            numOfSetBits(lSize - bSize - lAssoc),
-            lAssoc(lAssoc),
-            lCyc(lCyc),
-            bSize(bSize){
-        this->L = map<int,list<Entry> >();
+template <typename Addr>
+void CacheHierarchy<Addr>::updateByLRU(Addr address){
+    typename list<Entry<Addr> >::iterator line;
+    list<Entry<Addr> >* temp = locate(address, line);
+    if (temp == NULL)
+        return;
+    if (isSkewed()){
+        for (unsigned int way = 0; way < (1u << lAssoc); way++){
+            if (&L[keyOf(address, way)] == temp)
+                lastUse[keyOf(address, way) >> bSize] = ++useClock;
+        }
+        return;
     }
-    bool snoop(uint32_t address);
-    void add(uint32_t address);
-    void updateByLRU(uint32_t address);
-    Entry* remove(uint32_t address);
-    Entry* removeLast(uint32_t address);
-    bool isSetFull(uint32_t address);
-    void updateDirty(uint32_t address, bool isDirty);
-};
+    temp->splice(temp->begin(), *temp, line);
+}
 
 /**
- * Checks if the data in address is in the cache hierarchy
- * @param address for check
- * @return true if the data is inside the cache hierarchy and false otherwise
+ * moves the block holding address to the end of the LRU order of its set, the next one to be replaced
+ * @param address least recently used
  */
-bool CacheHierarchy::snoop(uint32_t address){
-
-    list<Entry> temp = L[getSet(address, numOfSetBits, bSize)];
-    std::list<Entry>::iterator it;
-    for (it = temp.begin(); it != temp.end(); ++it){
-        if (getTag(address, numOfSetBits, bSize) == getTag(it->address, numOfSetBits, bSize))
-            return true;
-    }
-    return false;
+template <typename Addr>
+void CacheHierarchy<Addr>::demote(Addr address){
+    typename list<Entry<Addr> >::iterator line;
+    list<Entry<Addr> >* temp = locate(address, line);
+    if (temp != NULL)
+        temp->splice(temp->end(), *temp, line);
 }
 
 /**
- * adds the block holding address to the cache hierarchy
- * @param address to add to cache
+ * @param address to look for
+ * @return the line that holds the block of address, NULL if the block is not in the cache hierarchy
  */
-void CacheHierarchy::add(uint32_t address){
-    Entry entry = Entry(address);
-    L[getSet(address, numOfSetBits, bSize)].push_front(entry);
+template <typename Addr>
+Entry<Addr>* CacheHierarchy<Addr>::lineOf(Addr address){
+    typename list<Entry<Addr> >::iterator line;
+    return locate(address, line) != NULL ? &*line : NULL;
 }
 
 /**
- * updates the cache hierarchies LRU order to reflect that address was used last
- * @param address most recently used
+ * exchanges the lines and the replacement state with a hierarchy of the same shape
+ * @param other hierarchy to exchange with
  */
-void CacheHierarchy::updateByLRU(uint32_t address){
-    list<Entry>* temp = &L[getSet(address, numOfSetBits, bSize)];
-    std::list<Entry>::iterator it;
-    for (it = temp->begin(); it != temp->end(); ++it){
-        if (getTag(address, numOfSetBits, bSize) == getTag(it->address, numOfSetBits, bSize)){
-            Entry entry = Entry(*it);
-            temp->erase(it);
-            temp->push_front(entry);
-            return;
-        }
-    }
+template <typename Addr>
+void CacheHierarchy<Addr>::swapLines(CacheHierarchy& other){
+    L.swap(other.L);
+    lastUse.swap(other.lastUse);
+    setMeta.swap(other.setMeta);
+    sectorMasks.swap(other.sectorMasks);
+    signatures.swap(other.signatures);
+    reusedBits.swap(other.reusedBits);
+    owners.swap(other.owners);
+    freeWays.swap(other.freeWays);
+    std::swap(useClock, other.useClock);
 }
 
 /**
  * removes the entry that holds the block relevant to address from cache hierarchy
- * @param address for removal
- * @return pointer to the entry that was removed
+ * @param address for removal, held by the hierarchy
+ * @return the entry that was removed
  */
-Entry* CacheHierarchy::remove(uint32_t address){
-    list<Entry>* temp = &L[getSet(address, numOfSetBits, bSize)];
-    std::list<Entry>::iterator it;
-    for (it = temp->begin(); it != temp->end(); ++it){
-        if (getTag(address,numOfSetBits,bSize) == getTag(it->address, numOfSetBits, bSize)){
-            Entry* entry = new Entry(*it);
-            temp->erase(it);
-            return entry;
-        }
-    }
-    return NULL;
+template <typename Addr>
+Entry<Addr> CacheHierarchy<Addr>::remove(Addr address){
+    typename list<Entry<Addr> >::iterator line;
+    list<Entry<Addr> >* temp = locate(address, line);
+    Entry<Addr> entry = *line;
+    releaseWay(entry);
+    temp->erase(line);
+    return entry;
 }
 
 /**
- * removes the last block in the LRU order In a relevant set.
+ * removes the last block in the LRU order In a relevant set, for a skewed level the least recently used of the
+ * lines the block could replace
  * @param address to decide which set needs removing from.
- * @return pointer to the entry that was removed
+ * @return the entry that was removed
  */
-Entry* CacheHierarchy::removeLast(uint32_t address) {
-    list<Entry>* temp = &L[getSet(address, numOfSetBits, bSize)];
-    std::list<Entry>::iterator lastElement = temp->end();
+template <typename Addr>
+Entry<Addr> CacheHierarchy<Addr>::removeLast(Addr address) {
+    list<Entry<Addr> >* temp = &L[keyOf(address, 0)];
+    if (isSkewed()){
+        unsigned long long oldest = lastUse[keyOf(address, 0) >> bSize];
+        for (unsigned int way = 1; way < (1u << lAssoc); way++){
+            int key = keyOf(address, way);
+            if (!L[key].empty() && (temp->empty() || lastUse[key >> bSize] < oldest)){
+                temp = &L[key];
+                oldest = lastUse[key >> bSize];
+            }
+        }
+    }
+    typename std::list<Entry<Addr> >::iterator lastElement = temp->end();
     lastElement--;
-    Entry* entry = new Entry(*lastElement);
+    Entry<Addr> entry = *lastElement;
+    releaseWay(entry);
     temp->erase(lastElement);
     return entry;
 }
 
+/**
+ * removes the least recently used line of a set among the lines in some of its ways
+ * @param address to decide which set needs removing from
+ * @param ways mask of the ways a line may be removed from, at least one of them holding a line
+ * @return the entry that was removed
+ */
+template <typename Addr>
+Entry<Addr> CacheHierarchy<Addr>::removeLast(Addr address, uint64_t ways){
+    list<Entry<Addr> >& set = L[keyOf(address, 0)];
+    typename list<Entry<Addr> >::iterator line = set.end();
+    do
+        --line;
+    while (((ways >> line->way) & 1) == 0);
+    Entry<Addr> entry = *line;
+    releaseWay(entry);
+    set.erase(line);
+    return entry;
+}
+
+/**
+ * @param address to decide the set
+ * @return the mask of the ways of the set that hold a line, for a level of at most 64 ways that tracks them
+ */
+template <typename Addr>
+uint64_t CacheHierarchy<Addr>::usedWays(Addr address) const{
+    return ~freeWays[(keyOf(address, 0) >> bSize) * wayWords()];
+}
+
+/**
+ * gives the way of a line that leaves a non-skewed level back to its set
+ * @param line line that was removed
+ */
+template <typename Addr>
+void CacheHierarchy<Addr>::releaseWay(const Entry<Addr>& line){
+    if (!freeWays.empty() && !isSkewed())
+        freeWays[(keyOf(line.address, 0) >> bSize) * wayWords() + line.way / 64] |= 1ull << (line.way % 64);
+}
+
 /**
  * checks if a relevant set is in capacity
  * @param address to decide which set needs checking.
  * @return true if set is full and false otherwise
  */
-bool CacheHierarchy::isSetFull(uint32_t address) {
-    int waysNum = pow(2,lAssoc);
-    if (L[getSet(address, numOfSetBits, bSize)].size() > waysNum)
-        throw std::exception();
-    if (L[getSet(address, numOfSetBits, bSize)].size() == waysNum)
+template <typename Addr>
+bool CacheHierarchy<Addr>::isSetFull(Addr address) {
+    unsigned int waysNum = 1u << lAssoc;    // the geometry is checked as it is loaded, no set grows past it
+    if (isSkewed()){
+        for (unsigned int way = 0; way < waysNum; way++){
+            if (L[keyOf(address, way)].empty())
+                return false;
+        }
         return true;
-    return false;
+    }
+    return L[keyOf(address, 0)].size() == waysNum;
 }
 
 /**
@@ -202,59 +237,95 @@ bool CacheHierarchy::isSetFull(uint32_t address) {
  * @param address to decide the block
  * @param isDirty wanted state
  */
-void CacheHierarchy::updateDirty(uint32_t address, bool isDirty) {
-    list<Entry>* temp = &L[getSet(address, numOfSetBits, bSize)];
-    std::list<Entry>::iterator it;
-    for (it = temp->begin(); it != temp->end(); ++it){
-        if (getTag(address, numOfSetBits, bSize) == getTag(it->address, numOfSetBits, bSize)){
-            it->dirtyBit = isDirty;
-        }
-    }
+template <typename Addr>
+void CacheHierarchy<Addr>::updateDirty(Addr address, bool isDirty) {
+    typename list<Entry<Addr> >::iterator line;
+    if (locate(address, line) != NULL)
+        line->dirtyBit = isDirty;
 }
 
+/**
+ * Checks if the sector holding address is valid in the cache hierarchy
+ * @param address for check
+ * @return true if the block is inside the cache hierarchy and its sector is valid, false otherwise
+ */
+template <typename Addr>
+bool CacheHierarchy<Addr>::snoopSector(Addr address){
+    typename list<Entry<Addr> >::iterator line;
+    return locate(address, line) != NULL && (sectorsOf(*line) & sectorOf(address)) != 0;
+}
 
 /**
- * a Class that represents an entire cache memory
+ * sets valid or dirty sector bits of the block holding address
+ * @param address to decide the block
+ * @param sectors bits to set, valid bits in the low half and dirty bits in the high half
  */
-class Cache{
-public:
-    int memCyc;
-    unsigned int bSize;
-    unsigned int wrAllocate;
-    unsigned int l1accesses;
-    unsigned int l1Misses;
-    unsigned int l2Misses;
-    uint32_t addToL1(uint32_t address, OPERATION op);
-    void addToL2(uint32_t address, OPERATION op);
-    CacheHierarchy l1;
-    CacheHierarchy l2;
-    Cache(int memCyc, unsigned int bSize, unsigned int wrAllocate, unsigned int l1Size, unsigned int l1Assoc,
-          unsigned int l1Cyc, unsigned int l2Size, unsigned int l2Assoc, unsigned int l2Cyc) : memCyc(memCyc),
-                                                                                            bSize(bSize),
-                                                                                            wrAllocate(wrAllocate),
-                                                                                            l1(l1Size, l1Assoc, l1Cyc, bSize),
-                                                                                            l2(l2Size, l2Assoc, l2Cyc, bSize),
-                                                                                            l1accesses(0),
-                                                                                            l1Misses(0), l2Misses(0){}
-    HIERARCHY inCache(uint32_t address);
-    void update(uint32_t address, OPERATION op);
-    double getL1MissRate(){
-        return double(l1Misses)/double(l1accesses);
-    }
-    double getL2MissRate(){
-        return double(l2Misses)/double(l1Misses);
-    }
-    double accTimeAVG(){
-        return (double((l1accesses * l1.lCyc) + (l1Misses * l2.lCyc) + (l2Misses * memCyc)) / double(l1accesses));
+template <typename Addr>
+void CacheHierarchy<Addr>::addSectors(Addr address, uint64_t sectors){
+    typename list<Entry<Addr> >::iterator line;
+    if (locate(address, line) != NULL && !sectorMasks.empty())
+        sectorMasks[slotOf(*line)] |= sectors;
+}
+
+/**
+ * @param address held by the hierarchy
+ * @return the position of its block in the LRU order of its set, 0 for the most recently used. the way that holds
+ *         it in a skewed level
+ */
+template <typename Addr>
+unsigned int CacheHierarchy<Addr>::wayOf(Addr address){
+    typename list<Entry<Addr> >::iterator line;
+    list<Entry<Addr> >* temp = locate(address, line);
+    unsigned int way = 0;
+    if (isSkewed()){
+        while (temp != NULL && &L[keyOf(address, way)] != temp)
+            way++;
+        return way;
     }
-};
+    for (typename list<Entry<Addr> >::iterator it = temp->begin(); it != line; ++it)
+        way++;
+    return way;
+}
+
+/**
+ * changes the index function of an empty hierarchy
+ * @param function index function of the sets
+ */
+template <typename Addr>
+void CacheHierarchy<Addr>::setIndexing(INDEX_FUNCTION function){
+    index = SetIndex(function, numOfSetBits);
+    if (isSkewed())
+        lastUse.assign(1ull << (numOfSetBits + lAssoc), 0);
+}
+
+/**
+ * runs the next accesses on the L1 of another core. the lines of the running core go back to its slot in
+ * privateL1s and the lines of the next one come out of its slot, which stays empty while it runs
+ * @param next core that makes the next accesses
+ */
+template <typename Addr>
+void Cache<Addr>::switchCore(unsigned int next){
+    if (next == core)
+        return;
+    l1.swapLines(privateL1s[core]);
+    l1.swapLines(privateL1s[next]);
+    core = next;
+}
 
 /**
  * checks if the data in a given address is kept in the cache memory
  * @param address for checking
  * @return true if a block holding the data is in the cache memory false otherwise
  */
-HIERARCHY Cache::inCache(uint32_t address){
+template <typename Addr>
+HIERARCHY Cache<Addr>::inCache(Addr address){
+    if (l1.isSectored()){   // a block whose sector is not valid misses as well
+        if (l1.snoopSector(address))
+            return L1;
+        if (l2.snoopSector(address))
+            return L2;
+        return MEM;
+    }
     if (this->l1.snoop(address))
         return L1;
     if (this->l2.snoop(address))
@@ -262,26 +333,80 @@ HIERARCHY Cache::inCache(uint32_t address){
     return MEM;
 }
 
+/**
+ * marks the block holding address dirty after a write, and the written sector when lines are sectored
+ * @param level hierarchy that holds the block, L2 for the stores of a write-through L1
+ * @param address written address
+ */
+template <typename Addr>
+void Cache<Addr>::markWritten(CacheHierarchy<Addr>& level, Addr address){
+    level.updateDirty(address, true);
+    if (level.isSectored())
+        level.addSectors(address, level.sectorOf(address) << DIRTY_SECTORS_SHIFT);
+}
+
+/**
+ * counts an access in the heatmaps of the levels it reached, before the LRU order moves
+ * @param address accessed address
+ * @param location the level that held it
+ */
+template <typename Addr>
+void Cache<Addr>::recordHeatmap(Addr address, HIERARCHY location){
+    uint64_t l1Set = l1.keyOf(address, 0) >> bSize;
+    l1Heatmap->access(l1Set);
+    if (location == L1){
+        l1Heatmap->hit(l1Set, l1.wayOf(address));
+        return;
+    }
+    l1Heatmap->miss(l1Set);
+    uint64_t l2Set = l2.keyOf(address, 0) >> bSize;
+    l2Heatmap->access(l2Set);
+    if (location == L2)
+        l2Heatmap->hit(l2Set, l2.wayOf(address));
+    else
+        l2Heatmap->miss(l2Set);
+}
+
 /**
  * updates the cache to hold a specific block by LRU order
  * @param address to dicide which block need keeping
  * @param op operation that was preformed on the block
  */
-void Cache::update(uint32_t address, OPERATION op) {
+template <typename Addr>
+void Cache<Addr>::update(Addr address, OPERATION op) {
     l1accesses++;
+    if (partition != NULL)
+        partition->access();
     HIERARCHY location = this->inCache(address);
+    if (l1Classifier != NULL)
+        l1Classifier->access(address, location != L1, location == L1 || op == READ || this->wrAllocate);
+    if (l2Classifier != NULL && location != L1)
+        l2Classifier->access(address, location == MEM, location == L2 || op == READ || this->wrAllocate);
+    if (attribution != NULL && location != L1)
+        attribution->miss(address, location == MEM);
+#ifdef CACHE_HEATMAP
+    if (l1Heatmap != NULL)
+        recordHeatmap(address, location);
+#endif
+    if (writeBuffer != NULL && op == WRITE)
+        writeBuffer->write(address >> bSize);
     if(location == L1) {
         l1.updateByLRU(address);
         if (op == WRITE)
-            l1.updateDirty(address, true);
+            markWritten(writeBuffer != NULL ? l2 : l1, address);
     }
     else if (location == L2){
         l1Misses++;
+        if (insertion != NULL){
+            size_t slot = l2.slotOf(*l2.lineOf(address));
+            l2.reusedBits[slot] = true;
+            insertion->reused(l2.signatures[slot]);
+        }
         if (op == READ || this->wrAllocate) {
-            uint32_t L1Removed = addToL1(address, op);
+            Addr L1Removed = addToL1(address, op);
             l1.updateByLRU(address);
             if (op == WRITE)
-                l1.updateDirty(address, true);
+                markWritten(writeBuffer != NULL ? l2 : l1, address);
             l2.updateByLRU(address);
             if (L1Removed != -1 and l2.snoop(L1Removed)){
                 l2.updateDirty(L1Removed, true);
@@ -290,19 +415,24 @@ void Cache::update(uint32_t address, OPERATION op) {
         }
         else{  // op == WRITE with no Write Allocate
             l2.updateByLRU(address);
-            l2.updateDirty(address, true);
+            markWritten(l2, address);
         }
     }
     else {
         l1Misses++;
         l2Misses++;
+        if (memory != NULL)
+            memory->access(address);
+        if (insertion != NULL)
+            insertion->miss(l2.setMeta[l2.keyOf(address, 0) >> bSize]);
         if (op == READ || this->wrAllocate){
-            addToL2(address, op);
-            uint32_t L1Removed = addToL1(address, op);
+            bool promote = addToL2(address, op);
+            Addr L1Removed = addToL1(address, op);
             l1.updateByLRU(address);
             if (op == WRITE)
-                l1.updateDirty(address, true);
-            l2.updateByLRU(address);
+                markWritten(writeBuffer != NULL ? l2 : l1, address);
+            if (promote)
+                l2.updateByLRU(address);
             if (L1Removed != -1 and l2.snoop(L1Removed)){
                 l2.updateDirty(L1Removed, true);
                 l2.updateByLRU(L1Removed);
@@ -314,20 +444,47 @@ void Cache::update(uint32_t address, OPERATION op) {
 }
 
 /**
- * adds a specific block to L1, and removes the LRU block if necessary
+ * adds a specific block to L1, and removes the LRU block if necessary. when a sectored line of the block is
+ * already there only the sector of address becomes valid
  * @param address to decide which block needs to be added
  * @param op that was preformed on the address
  * @return a the address of the removed entry if there was one, -1 otherwise
  */
-uint32_t Cache::addToL1(uint32_t address, OPERATION op){
-    uint32_t retAdr = -1;
+template <typename Addr>
+Addr Cache<Addr>::addToL1(Addr address, OPERATION op){
+    Addr retAdr = -1;
     if (op == READ || wrAllocate){
+        if (l1.isSectored() && l1.snoop(address)){   // the line is there without the sector
+            l1.addSectors(address, l1.sectorOf(address));
+            l1.updateByLRU(address);
+            return retAdr;
+        }
         if (l1.isSetFull(address)){
-            Entry l1Remove = *l1.removeLast(address);
+#ifdef CACHE_HEATMAP
+            if (l1Heatmap != NULL)
+                l1Heatmap->eviction(l1.keyOf(address, 0) >> bSize);
+#endif
+            Entry<Addr> l1Remove = l1.removeLast(address);
+            l1Evictions++;
             if (l1Remove.dirtyBit){
+                l1Writebacks++;
+                if (attribution != NULL)
+                    attribution->writeback(l1Remove.address, false);
                 l2.updateDirty(l1Remove.address, true);
+                if (l2.isSectored())
+                    l2.addSectors(l1Remove.address, l1.sectorsOf(l1Remove) & ~VALID_SECTORS);
                 l2.updateByLRU(l1Remove.address);
                 retAdr = l1Remove.address;
+                if (insertion != NULL && !l2.snoop(l1Remove.address)){  // a bypassed block goes to memory
+                    writtenBytes += l1.isSectored() ?
+                                    __builtin_popcountll(l1.sectorsOf(l1Remove) >> DIRTY_SECTORS_SHIFT) << l1.sectorBits :
+                                    1ull << bSize;
+                    l2Writebacks++;
+                    if (attribution != NULL)
+                        attribution->writeback(l1Remove.address, true);
+                    if (memory != NULL)
+                        memory->writeback(l1Remove.address);
+                }
             }
         }
         l1.add(address);
@@ -340,24 +497,89 @@ uint32_t Cache::addToL1(uint32_t address, OPERATION op){
 
 
 /**
- * adds a specific block to L2, and removes the LRU block if necessary
+ * adds a specific block to L2, and removes the LRU block if necessary. when a sectored line of the block is
+ * already there only the sector of address becomes valid. the insertion policy may put the block at LRU or leave
+ * it out of L2
  * @param address to decide which block needs to be added
  * @param op that was preformed on the address
+ * @return false when the block must not be moved to MRU
  */
-void Cache::addToL2(uint32_t address, OPERATION op){
+template <typename Addr>
+bool Cache<Addr>::addToL2(Addr address, OPERATION op){
     if (op == READ || wrAllocate){
-        if (l2.isSetFull(address)){
-            Entry l2Remove = *l2.removeLast(address);
-            if (l1.snoop(l2Remove.address)){
-                Entry l1Remove = *l1.remove(l2Remove.address);
-                // if l1Remove is dirty write its value to mem, else write l2Remove
+        unsigned long long blockBytes = 1ull << bSize, sectorBytes = 1ull << l2.sectorBits;
+        fetchedBytes += sectorBytes;
+        savedBytes += blockBytes - sectorBytes;
+        if (l2.isSectored() && l2.snoop(address)){   // the line is there without the sector
+            l2.addSectors(address, l2.sectorOf(address));
+            l2.updateByLRU(address);
+            return true;
+        }
+        uint16_t signature = insertion != NULL ? insertion->signatureOf(address) : 0;
+        if (insertion != NULL && insertion->bypass(signature))
+            return false;
+        // a partitioned core replaces the LRU line of its ways, or fills a free one of them
+        uint64_t ways = partition != NULL && !partition->unrestricted(core) ? partition->maskOf(core) : 0;
+        uint64_t freeWays = partition != NULL ? ~l2.usedWays(address) : 0;
+        if (ways != 0 ? (freeWays & ways) == 0 : l2.isSetFull(address)){
+#ifdef CACHE_HEATMAP
+            if (l2Heatmap != NULL)
+                l2Heatmap->eviction(l2.keyOf(address, 0) >> bSize);
+#endif
+            Entry<Addr> l2Remove = ways != 0 ? l2.removeLast(address, ways) : l2.removeLast(address);
+            l2Evictions++;
+            size_t slot = l2.slotOf(l2Remove);
+            if (partition != NULL){
+                partition->evict(l2.owners[slot]);
+                freeWays = 1ull << l2Remove.way;
+            }
+            if (insertion != NULL)
+                insertion->evicted(l2.signatures[slot], l2.reusedBits[slot]);
+            bool dirty = l2Remove.dirtyBit;
+            uint64_t dirtySectors = l2.sectorsOf(l2Remove) >> DIRTY_SECTORS_SHIFT;
+            for (unsigned int other = 0; other <= privateL1s.size(); other++){  // every L1 holding a copy
+                CacheHierarchy<Addr>& level = other < privateL1s.size() ? privateL1s[other] : l1;
+                if (level.snoop(l2Remove.address)){
+                    Entry<Addr> l1Remove = level.remove(l2Remove.address);
+                    dirty = dirty || l1Remove.dirtyBit;     // the L1 copy is the newer one when it is dirty
+                    dirtySectors |= level.sectorsOf(l1Remove) >> DIRTY_SECTORS_SHIFT;
+                }
+            }
+            if (dirty){
+                unsigned long long written = l2.isSectored() ? __builtin_popcountll(dirtySectors) * sectorBytes :
+                                             blockBytes;
+                writtenBytes += written;
+                savedBytes += blockBytes - written;
+                l2Writebacks++;
+                if (attribution != NULL)
+                    attribution->writeback(l2Remove.address, true);
+                if (memory != NULL)
+                    memory->writeback(l2Remove.address);
+            }
+        }
+        l2.add(address, partition != NULL ? __builtin_ctzll(ways != 0 ? freeWays & ways : freeWays) : -1);
+        size_t slot = l2.slotOf(*l2.lineOf(address));
+        if (partition != NULL){
+            l2.owners[slot] = core;
+            partition->fill(core);
+        }
+        if (insertion != NULL){
+            l2.signatures[slot] = signature;
+            if (!insertion->insertAtMRU(l2.setMeta[l2.keyOf(address, 0) >> bSize])){
+                l2.demote(address);
+                return false;
             }
         }
-        l2.add(address);
         l2.updateByLRU(address);
+        return true;
     }
     else{ // op == WRITE with no Write Allocate
-            return;
+            return false;
 
     }
-}
\ No newline at end of file
+}
+
+template class CacheHierarchy<uint32_t>;
+template class CacheHierarchy<uint64_t>;
+template class Cache<uint32_t>;
+template class Cache<uint64_t>;
@@ -0,0 +1,441 @@
+//
+// Created by nadav ashkenazi on 15/12/2020.
+//
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <map>
+#include <list>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include "missClassifier.h"
+#include "attribution.h"
+#include "memoryBackend.h"
+#include "heatmap.h"
+#include "setIndex.h"
+#include "writeBuffer.h"
+#include "insertion.h"
+#include "wayPartition.h"
+
+using namespace std;
+
+enum HIERARCHY {L1, L2, MEM};
+enum OPERATION {READ, WRITE};
+
+/**
+ * returns the tag which is the bits from #(blockBits + setBits) until the end  where every bit not
+ * used for tag 0;
+ * @param address - address to extract tag
+ * @param numOfSetBits - number of bit used for deciding set
+ * @param bSize -block size
+ * @return the relevant tag
+ */
+template <typename Addr>
+Addr getTag(Addr address, int numOfSetBits, int bSize){
+    Addr mask = 0;
+    for (int i = 0; i < numOfSetBits + bSize; i++){
+        mask = mask << 1;
+        mask += 1;
+    }
+    Addr res = address & (~mask);
+    return res;
+}
+
+/**
+ * returns the set which is the bits from #(blockBits) until #(blockBits+setBits) as a 32 bit address where every bit not
+ * used for set is 0;
+ * @param address -address to extract set from
+ * @param numOfSetBits - number of bit used for deciding set
+ * @param bSize -block size
+ * @return the relevant set
+ */
+template <typename Addr>
+Addr getSet(Addr address, int numOfSetBits, int bSize){
+    Addr mask = 0;
+    for (int i = 0; i < numOfSetBits; i++){
+        mask = mask << 1;
+        mask += 1;
+    }
+    for (int i = 0; i <  bSize; i++){
+        mask = mask << 1;
+    }
+    Addr res = address & mask;
+    return res;
+}
+
+/**
+ * returns the offset which is the bits from the start until #(blockBits) as a 32 bit address where every bit not
+ * used for offset is 0;
+ * @param address -address to extract set from
+ * @param bSize -block size
+ * @return the relevant set
+ */
+template <typename Addr>
+Addr getOffset(Addr address, int bSize){
+    Addr mask = 0;
+
+    for (int i = 0; i < bSize; i++){
+        mask = mask << 1;
+        mask += 1;
+    }
+    return address & mask;
+}
+
+static const unsigned int MAX_SECTORS = 5;            // log2 of the sectors a line can be split into
+static const unsigned int DIRTY_SECTORS_SHIFT = 32;
+static const uint64_t VALID_SECTORS = 0xffffffffull;   // every sector valid and none dirty
+static const unsigned int MAX_WAY_BITS = 16;          // log2 of the ways the way of an entry can name
+
+/**
+ * a Class that hold the relevant data for an entry inside the cache
+ * way is the way of its set that holds the line, which stays the same while the line moves in the LRU order.
+ * it places the line in the per-line arrays of its hierarchy, so the metadata of optional features stays out
+ * of the entry and a 32 bit entry keeps its 8 bytes.
+ */
+template <typename Addr>
+class Entry{
+public:
+    const Addr address;
+    bool dirtyBit;
+    bool validBit;
+    uint16_t way;
+    Entry(Addr address, bool dirtyBit = 0, bool validBit =1, uint16_t way = 0) : address(address),
+            dirtyBit(dirtyBit), validBit(validBit), way(way){}
+    /**
+     * copies an entry that holds a narrower address
+     */
+    template <typename Narrow>
+    explicit Entry(const Entry<Narrow>& narrow) : address(narrow.address), dirtyBit(narrow.dirtyBit),
+            validBit(narrow.validBit), way(narrow.way){}
+};
+
+
+/**
+ * a Class that represents a single hierarchy inside the cache memory such as L1 or L2
+ */
+template <typename Addr>
+class CacheHierarchy{
+public:
+    const unsigned int numOfSetBits;
+    const unsigned int lAssoc;
+    const unsigned int lCyc;
+    const unsigned int bSize;
+    unsigned int sectorBits;    // log2 of the bytes of a sector, bSize when lines are not sectored
+    SetIndex index;
+    map<int,list<Entry<Addr> > > L;     // keyed by set << bSize, a skewed level has a list per way and set
+    vector<unsigned long long> lastUse; // skewed level: LRU stamp of every line, by way and set
+    unsigned long long useClock;
+    vector<uint8_t> setMeta;    // packed per-set metadata, one byte per set, empty unless a policy keeps some
+    // per-line metadata indexed by slotOf, each array empty unless the feature that keeps it is on
+    vector<uint64_t> sectorMasks;   // sectored level: a valid bit per sector in the low half, a dirty bit in the high
+    vector<uint16_t> signatures;    // dead block predictor: what filled the line
+    vector<uint8_t> reusedBits;     // dead block predictor: the line was hit after its fill
+    vector<uint8_t> owners;         // partitioned level: the requestor that filled the line
+    vector<uint64_t> freeWays;      // a bit per way of every set that holds no line, empty unless the level has
+                                    // per-line arrays, the only ones that need the way of a line
+    CacheHierarchy(unsigned int lSize = 0, unsigned int lAssoc =0, unsigned int lCyc = 0, unsigned int bSize =0) :
+            numOfSetBits(lSize - bSize - lAssoc),
+            lAssoc(lAssoc),
+            lCyc(lCyc),
+            bSize(bSize),
+            sectorBits(bSize),
+            index(BIT_SELECT, lSize - bSize - lAssoc),
+            useClock(0){
+        this->L = map<int,list<Entry<Addr> > >();
+    }
+    /**
+     * copies a hierarchy that holds narrower addresses, keeping every entry and the LRU order
+     * @param narrow hierarchy to copy
+     */
+    template <typename Narrow>
+    explicit CacheHierarchy(const CacheHierarchy<Narrow>& narrow) :
+            numOfSetBits(narrow.numOfSetBits),
+            lAssoc(narrow.lAssoc),
+            lCyc(narrow.lCyc),
+            bSize(narrow.bSize),
+            sectorBits(narrow.sectorBits),
+            index(narrow.index),
+            lastUse(narrow.lastUse),
+            useClock(narrow.useClock),
+            setMeta(narrow.setMeta),
+            sectorMasks(narrow.sectorMasks),
+            signatures(narrow.signatures),
+            reusedBits(narrow.reusedBits),
+            owners(narrow.owners),
+            freeWays(narrow.freeWays){
+        typename map<int,list<Entry<Narrow> > >::const_iterator set;
+        for (set = narrow.L.begin(); set != narrow.L.end(); ++set){
+            typename list<Entry<Narrow> >::const_iterator it;
+            for (it = set->second.begin(); it != set->second.end(); ++it)
+                L[set->first].push_back(Entry<Addr>(*it));
+        }
+    }
+    bool snoop(Addr address);
+    void add(Addr address, int way = -1);
+    void updateByLRU(Addr address);
+    void demote(Addr address);
+    Entry<Addr>* lineOf(Addr address);
+    void swapLines(CacheHierarchy& other);
+    Entry<Addr> remove(Addr address);
+    Entry<Addr> removeLast(Addr address);
+    Entry<Addr> removeLast(Addr address, uint64_t ways);
+    uint64_t usedWays(Addr address) const;
+    bool isSetFull(Addr address);
+    void updateDirty(Addr address, bool isDirty);
+    bool isSectored() const{
+        return sectorBits < bSize;
+    }
+    /**
+     * splits the lines of an empty hierarchy into sectors
+     * @param sectors log2 of the sectors of a line
+     */
+    void setSectors(unsigned int sectors){
+        sectorBits = bSize - sectors;
+        sectorMasks.assign(1ull << (numOfSetBits + lAssoc), VALID_SECTORS);
+        trackWays();
+    }
+    /**
+     * @return the words of freeWays that hold the bits of one set
+     */
+    size_t wayWords() const{
+        return lAssoc > 6 ? (size_t)1 << (lAssoc - 6) : 1;
+    }
+    /**
+     * gives every line added to an empty level a way of its set, so that it owns a slot of the per-line arrays
+     */
+    void trackWays(){
+        freeWays.assign(wayWords() << numOfSetBits, lAssoc >= 6 ? ~0ull : (1ull << (1u << lAssoc)) - 1);
+    }
+    /**
+     * @param line line of the hierarchy
+     * @return the index of the line in the per-line arrays, from its set and its way
+     */
+    size_t slotOf(const Entry<Addr>& line) const{
+        if (isSkewed())
+            return keyOf(line.address, line.way) >> bSize;  // the set of a skewed level already names its way
+        return ((size_t)(keyOf(line.address, 0) >> bSize) << lAssoc) | line.way;
+    }
+    /**
+     * @return the valid and dirty sector bits of a line, every sector valid and clean when lines are not sectored
+     */
+    uint64_t sectorsOf(const Entry<Addr>& line) const{
+        return sectorMasks.empty() ? VALID_SECTORS : sectorMasks[slotOf(line)];
+    }
+    /**
+     * @return the valid bit of the sector that holds address
+     */
+    uint64_t sectorOf(Addr address) const{
+        return 1ull << (getOffset(address, bSize) >> sectorBits);
+    }
+    bool snoopSector(Addr address);
+    void addSectors(Addr address, uint64_t sectors);
+    unsigned int wayOf(Addr address);
+    void setIndexing(INDEX_FUNCTION function);
+    bool isSkewed() const{
+        return index.getFunction() == SKEWED;
+    }
+    /**
+     * @return the key of the set of address in L, for a skewed level the key of the set in the given way
+     */
+    int keyOf(Addr address, unsigned int way) const{
+        uint64_t set = index.of(address >> bSize, way);
+        if (isSkewed())
+            set |= (uint64_t)way << numOfSetBits;
+        return set << bSize;
+    }
+private:
+    list<Entry<Addr> >* locate(Addr address, typename list<Entry<Addr> >::iterator& line);
+    void releaseWay(const Entry<Addr>& line);
+};
+
+/**
+ * a Class that represents an entire cache memory
+ */
+template <typename Addr>
+class Cache{
+public:
+    int memCyc;
+    unsigned int bSize;
+    unsigned int wrAllocate;
+    unsigned long long l1accesses;
+    unsigned long long l1Misses;
+    unsigned long long l2Misses;
+    unsigned long long l1Writebacks;
+    unsigned long long l2Writebacks;
+    unsigned long long l1Evictions; // valid lines replaced to make room, clean or dirty
+    unsigned long long l2Evictions;
+    unsigned long long fetchedBytes;    // memory traffic: fills of L2 from memory
+    unsigned long long writtenBytes;    // memory traffic: dirty data written back from L2
+    unsigned long long savedBytes;      // bytes whole lines would have added to the fills and writebacks
+    Addr addToL1(Addr address, OPERATION op);
+    bool addToL2(Addr address, OPERATION op);
+    CacheHierarchy<Addr> l1;
+    CacheHierarchy<Addr> l2;
+    MissClassifier* l1Classifier;
+    MissClassifier* l2Classifier;
+    AccessAttribution* attribution;
+    MemoryBackend* memory;      // NULL for the flat memCyc latency
+    SetHeatmap* l1Heatmap;      // per-set counters, only updated when built with CACHE_HEATMAP
+    SetHeatmap* l2Heatmap;
+    WriteBuffer* writeBuffer;   // write-through L1: stores go to L2 through it, NULL for a write-back L1
+    AdaptiveInsertion* insertion;   // L2 insertion and bypass, NULL to insert every block at MRU
+    vector<CacheHierarchy<Addr> > privateL1s;   // co-scheduled traces: the L1 of every core but the running one
+    unsigned int core;          // the core whose L1 is in l1
+    WayPartition* partition;    // L2 way masks per core, NULL to fill any way
+    Cache(int memCyc, unsigned int bSize, unsigned int wrAllocate, unsigned int l1Size, unsigned int l1Assoc,
+          unsigned int l1Cyc, unsigned int l2Size, unsigned int l2Assoc, unsigned int l2Cyc) : memCyc(memCyc),
+                                                                                            bSize(bSize),
+                                                                                            wrAllocate(wrAllocate),
+                                                                                            l1(l1Size, l1Assoc, l1Cyc, bSize),
+                                                                                            l2(l2Size, l2Assoc, l2Cyc, bSize),
+                                                                                            l1accesses(0),
+                                                                                            l1Misses(0), l2Misses(0),
+                                                                                            l1Writebacks(0),
+                                                                                            l2Writebacks(0),
+                                                                                            l1Evictions(0),
+                                                                                            l2Evictions(0),
+                                                                                            fetchedBytes(0),
+                                                                                            writtenBytes(0),
+                                                                                            savedBytes(0),
+                                                                                            l1Classifier(NULL),
+                                                                                            l2Classifier(NULL),
+                                                                                            attribution(NULL),
+                                                                                            memory(NULL),
+                                                                                            l1Heatmap(NULL),
+                                                                                            l2Heatmap(NULL),
+                                                                                            writeBuffer(NULL),
+                                                                                            insertion(NULL),
+                                                                                            core(0),
+                                                                                            partition(NULL){}
+    /**
+     * takes over the state of a cache with narrower addresses, used once a trace turns out to need wider addresses
+     * @param narrow cache to take over, it keeps its entries but loses its classifiers, attribution, memory,
+     *        heatmaps, write buffer, insertion policy and partitions, and its private L1s are copied
+     */
+    template <typename Narrow>
+    explicit Cache(Cache<Narrow>& narrow) : memCyc(narrow.memCyc),
+                                            bSize(narrow.bSize),
+                                            wrAllocate(narrow.wrAllocate),
+                                            l1accesses(narrow.l1accesses),
+                                            l1Misses(narrow.l1Misses), l2Misses(narrow.l2Misses),
+                                            l1Writebacks(narrow.l1Writebacks), l2Writebacks(narrow.l2Writebacks),
+                                            l1Evictions(narrow.l1Evictions), l2Evictions(narrow.l2Evictions),
+                                            fetchedBytes(narrow.fetchedBytes), writtenBytes(narrow.writtenBytes),
+                                            savedBytes(narrow.savedBytes),
+                                            l1(narrow.l1),
+                                            l2(narrow.l2),
+                                            l1Classifier(narrow.l1Classifier),
+                                            l2Classifier(narrow.l2Classifier),
+                                            attribution(narrow.attribution),
+                                            memory(narrow.memory),
+                                            l1Heatmap(narrow.l1Heatmap),
+                                            l2Heatmap(narrow.l2Heatmap),
+                                            writeBuffer(narrow.writeBuffer),
+                                            insertion(narrow.insertion),
+                                            privateL1s(narrow.privateL1s.begin(), narrow.privateL1s.end()),
+                                            core(narrow.core),
+                                            partition(narrow.partition){
+        narrow.l1Classifier = NULL;
+        narrow.l2Classifier = NULL;
+        narrow.attribution = NULL;
+        narrow.memory = NULL;
+        narrow.l1Heatmap = NULL;
+        narrow.l2Heatmap = NULL;
+        narrow.writeBuffer = NULL;
+        narrow.insertion = NULL;
+        narrow.partition = NULL;
+    }
+    Cache(const Cache&) = delete;
+    Cache& operator=(const Cache&) = delete;
+    ~Cache(){
+        delete l1Classifier;
+        delete l2Classifier;
+        delete attribution;
+        delete memory;
+        delete l1Heatmap;
+        delete l2Heatmap;
+        delete writeBuffer;
+        delete insertion;
+        delete partition;
+    }
+    void enableMissClassification(unsigned int l1Size, unsigned int l2Size){
+        l1Classifier = new MissClassifier(l1Size, bSize);
+        l2Classifier = new MissClassifier(l2Size, bSize);
+    }
+    void enableAttribution(unsigned int regionBits, unsigned int capacity){
+        attribution = new AccessAttribution(regionBits, capacity);
+    }
+    void enableDram(const DramConfig& config){
+        memory = new DramMemory(config);
+    }
+    void enableHeatmap(){
+        l1Heatmap = new SetHeatmap(l1.numOfSetBits, l1.lAssoc);
+        l2Heatmap = new SetHeatmap(l2.numOfSetBits, l2.lAssoc);
+    }
+    void enableWriteThrough(unsigned int depth, unsigned int drainCyc){
+        writeBuffer = new WriteBuffer(depth, drainCyc);
+    }
+    /**
+     * @param policy insertion policy of L2, the sets of a dynamic policy get their roles in the set metadata
+     * @param bypass leave the blocks predicted dead out of L2
+     * @param regionBits log2 of the bytes of a region of the dead block predictor
+     */
+    void enableInsertion(INSERTION_POLICY policy, bool bypass, unsigned int regionBits){
+        insertion = new AdaptiveInsertion(policy, bypass, regionBits);
+        l2.setMeta.assign(1ull << l2.numOfSetBits, FOLLOWER_SET);
+        l2.signatures.assign(1ull << (l2.numOfSetBits + l2.lAssoc), 0);
+        l2.reusedBits.assign(1ull << (l2.numOfSetBits + l2.lAssoc), 0);
+        l2.trackWays();
+        for (uint64_t set = 0; policy == DIP_INSERTION && set < l2.setMeta.size(); set++)
+            l2.setMeta[set] = AdaptiveInsertion::roleOf(set, l2.numOfSetBits);
+    }
+    /**
+     * gives every core a private L1 shaped like l1, which holds the L1 of core 0 until switchCore
+     * @param cores number of cores sharing L2
+     */
+    void enableCores(unsigned int cores){
+        privateL1s = vector<CacheHierarchy<Addr> >(cores, l1);
+    }
+    void switchCore(unsigned int next);
+    /**
+     * @param schedule L2 way masks of every core, one partitioning per interval
+     * @param interval accesses between repartitionings, 0 keeps the first partitioning
+     */
+    void enablePartitions(const vector<vector<uint64_t> >& schedule, unsigned long long interval){
+        partition = new WayPartition(schedule, interval, 1u << l2.lAssoc, 1ull << (l2.numOfSetBits + l2.lAssoc));
+        l2.owners.assign(1ull << (l2.numOfSetBits + l2.lAssoc), 0);
+        l2.trackWays();
+    }
+    void enableIndexing(INDEX_FUNCTION l1Index, INDEX_FUNCTION l2Index){
+        l1.setIndexing(l1Index);
+        l2.setIndexing(l2Index);
+    }
+    void enableSectors(unsigned int sectors){
+        l1.setSectors(sectors);
+        l2.setSectors(sectors);
+    }
+    HIERARCHY inCache(Addr address);
+    void markWritten(CacheHierarchy<Addr>& level, Addr address);
+    void recordHeatmap(Addr address, HIERARCHY location);
+    void update(Addr address, OPERATION op);
+    bool saveState(const char* path);
+    bool loadState(const char* path);
+    double getL1MissRate(){
+        return double(l1Misses)/double(l1accesses);
+    }
+    double getL2MissRate(){
+        return double(l2Misses)/double(l1Misses);
+    }
+    unsigned long long totalCycles(){
+        return (unsigned long long)l1accesses * l1.lCyc + (unsigned long long)l1Misses * l2.lCyc +
+               (memory != NULL ? memory->cycles : (unsigned long long)l2Misses * memCyc) +
+               (writeBuffer != NULL ? writeBuffer->stallCycles : 0);
+    }
+    double accTimeAVG(){
+        return double(totalCycles()) / double(l1accesses);
+    }
+};
+
+#endif // CACHE_H
@@ -0,0 +1,396 @@
+//
+// Library interface of the cache simulator: a two level cache fed one access (or one trace) at a time.
+//
+
+#include <limits>
+#include "checkpoint.h"
+#include "cacheSimulator.h"
+
+/**
+ * @param config geometry and timing of the cache, 64 address bits skip the 32 bit engine
+ */
+CacheSimulator::CacheSimulator(const CacheConfig& config) : config(config), narrow(NULL), wide(NULL), tlb(NULL),
+                                                            timing(NULL),
+                                                            traceStats(config.traces, CacheStats()){
+    if (config.addressBits == 64)
+        wide = new Cache<uint64_t>(config.memCyc, config.bSize, config.wrAllocate, config.l1Size, config.l1Assoc,
+                                   config.l1Cyc, config.l2Size, config.l2Assoc, config.l2Cyc);
+    else
+        narrow = new Cache<uint32_t>(config.memCyc, config.bSize, config.wrAllocate, config.l1Size,
+                                     config.l1Assoc, config.l1Cyc, config.l2Size, config.l2Assoc, config.l2Cyc);
+    if (config.classifyMisses){
+        if (wide != NULL)
+            wide->enableMissClassification(config.l1Size, config.l2Size);
+        else
+            narrow->enableMissClassification(config.l1Size, config.l2Size);
+    }
+    if (config.attribute){
+        if (wide != NULL)
+            wide->enableAttribution(config.regionBits, config.attributionSlots);
+        else
+            narrow->enableAttribution(config.regionBits, config.attributionSlots);
+    }
+    if (config.l1WriteThrough){
+        unsigned int drainCyc = config.writeBufferCyc ? config.writeBufferCyc : config.l2Cyc;
+        if (wide != NULL)
+            wide->enableWriteThrough(config.writeBuffer, drainCyc);
+        else
+            narrow->enableWriteThrough(config.writeBuffer, drainCyc);
+    }
+    if (config.l1Index != BIT_SELECT || config.l2Index != BIT_SELECT){
+        if (wide != NULL)
+            wide->enableIndexing(config.l1Index, config.l2Index);
+        else
+            narrow->enableIndexing(config.l1Index, config.l2Index);
+    }
+    if (config.l2Insertion != LRU_INSERTION || config.l2Bypass){
+        if (wide != NULL)
+            wide->enableInsertion(config.l2Insertion, config.l2Bypass, config.bypassRegionBits);
+        else
+            narrow->enableInsertion(config.l2Insertion, config.l2Bypass, config.bypassRegionBits);
+    }
+    if (config.heatmap){
+        if (wide != NULL)
+            wide->enableHeatmap();
+        else
+            narrow->enableHeatmap();
+    }
+    if (config.sectors){
+        if (wide != NULL)
+            wide->enableSectors(config.sectors);
+        else
+            narrow->enableSectors(config.sectors);
+    }
+    if (config.dram.enabled){
+        if (wide != NULL)
+            wide->enableDram(config.dram);
+        else
+            narrow->enableDram(config.dram);
+    }
+    if (config.traces > 1){
+        if (wide != NULL)
+            wide->enableCores(config.traces);
+        else
+            narrow->enableCores(config.traces);
+    }
+    // masks of every way leave L2 as it is without partitions
+    if (WayPartition::restricts(config.wayMasks, 1u << config.l2Assoc)){
+        if (wide != NULL)
+            wide->enablePartitions(config.wayMasks, config.repartitionInterval);
+        else
+            narrow->enablePartitions(config.wayMasks, config.repartitionInterval);
+    }
+    if (config.tlb.enabled)
+        tlb = new Tlb(config.tlb);
+    if (config.timing.enabled)
+        timing = new TimingModel(config.timing, config.l1Cyc, config.l2Cyc, config.bSize,
+                                 config.l2Size - config.bSize - config.l2Assoc);
+}
+
+CacheSimulator::~CacheSimulator(){
+    delete narrow;
+    delete wide;
+    delete tlb;
+    delete timing;
+}
+
+/**
+ * moves the 32 bit cache to 64 bit addresses, keeping its entries, counters and classifiers
+ */
+void CacheSimulator::widen(){
+    wide = new Cache<uint64_t>(*narrow);
+    delete narrow;
+    narrow = NULL;
+}
+
+/**
+ * translates an address, simulates the access and times it
+ * @param address accessed address, virtual when the TLB is on
+ * @param op operation performed on the address
+ */
+void CacheSimulator::simulate(uint64_t address, OPERATION op){
+    if (tlb != NULL)
+        address = tlb->translate(address);
+    if (narrow != NULL && address > numeric_limits<uint32_t>::max())
+        widen();
+    unsigned long long l1Misses = wide != NULL ? wide->l1Misses : narrow->l1Misses;
+    unsigned long long l2Misses = wide != NULL ? wide->l2Misses : narrow->l2Misses;
+    MemoryBackend* memory = wide != NULL ? wide->memory : narrow->memory;
+    WriteBuffer* writeBuffer = wide != NULL ? wide->writeBuffer : narrow->writeBuffer;
+    unsigned long long memCycles = 0, stallCycles = 0;
+    // accesses are back to back without the timing mode
+    unsigned long long now = timing != NULL ? timing->issueCycle() :
+                             wide != NULL ? wide->totalCycles() : narrow->totalCycles();
+    if (memory != NULL){
+        // a miss reaches the memory after both cache lookups, and the waits for MSHRs and the L2 bank in timing mode
+        memCycles = memory->cycles;
+        memory->now = timing != NULL ? timing->memoryCycle(address) : now + config.l1Cyc + config.l2Cyc;
+    }
+    if (writeBuffer != NULL){
+        // a store reaches the buffer after the L1 lookup
+        stallCycles = writeBuffer->stallCycles;
+        writeBuffer->now = now + config.l1Cyc;
+    }
+    if (wide != NULL)
+        wide->update(address, op);
+    else
+        narrow->update(address, op);
+    if (timing != NULL){
+        // the level that served the access, from the miss counters it moved
+        bool l1Miss = (wide != NULL ? wide->l1Misses : narrow->l1Misses) != l1Misses;
+        bool l2Miss = (wide != NULL ? wide->l2Misses : narrow->l2Misses) != l2Misses;
+        timing->access(address, l2Miss ? MEM : l1Miss ? L2 : L1,
+                       memory != NULL ? memory->cycles - memCycles : config.memCyc);
+        if (writeBuffer != NULL)
+            timing->stall(writeBuffer->stallCycles - stallCycles);
+    }
+}
+
+/**
+ * simulates a single access, issued when the previous one completes in timing mode
+ * @param address accessed address, virtual when the TLB is on
+ * @param op operation performed on the address
+ */
+void CacheSimulator::feed(uint64_t address, OPERATION op){
+    if (timing != NULL)
+        timing->issue(NO_TIME, 0);
+    simulate(address, op);
+}
+
+/**
+ * simulates a single trace record, 'w' is a write and every other operation a read
+ */
+void CacheSimulator::feed(const TraceRecord& record){
+    if (config.attribute){
+        AccessAttribution* attribution = wide != NULL ? wide->attribution : narrow->attribution;
+        attribution->setPC(record.pc);
+    }
+    AdaptiveInsertion* insertion = wide != NULL ? wide->insertion : narrow->insertion;
+    if (insertion != NULL)
+        insertion->setPC(record.pc);
+    if (timing != NULL)
+        timing->issue(record.timeKind, record.time);
+    simulate(record.address, record.operation == 'w' ? WRITE : READ);
+}
+
+/**
+ * simulates a trace record of one of the co-scheduled traces on the L1 of its core, and counts it for the trace
+ * @param record access to simulate
+ * @param trace number of the trace, below config.traces
+ */
+void CacheSimulator::feed(const TraceRecord& record, unsigned int trace){
+    if (wide != NULL)
+        wide->switchCore(trace);
+    else
+        narrow->switchCore(trace);
+    CacheStats before = counters();
+    feed(record);
+    CacheStats after = counters();
+    CacheStats& stats = traceStats[trace];
+    stats.l1accesses += after.l1accesses - before.l1accesses;
+    stats.l1Misses += after.l1Misses - before.l1Misses;
+    stats.l2Misses += after.l2Misses - before.l2Misses;
+    stats.l1Writebacks += after.l1Writebacks - before.l1Writebacks;
+    stats.l2Writebacks += after.l2Writebacks - before.l2Writebacks;
+    stats.l1Evictions += after.l1Evictions - before.l1Evictions;
+    stats.l2Evictions += after.l2Evictions - before.l2Evictions;
+    stats.fetchedBytes += after.fetchedBytes - before.fetchedBytes;
+    stats.writtenBytes += after.writtenBytes - before.writtenBytes;
+    stats.savedBytes += after.savedBytes - before.savedBytes;
+    stats.totalCycles += after.totalCycles - before.totalCycles;
+}
+
+/**
+ * simulates consecutive trace records
+ * @param records first record
+ * @param count number of records
+ */
+void CacheSimulator::feed(const TraceRecord* records, size_t count){
+    for (size_t i = 0; i < count; i++)
+        feed(records[i]);
+}
+
+/**
+ * simulates a whole trace
+ * @param source trace to simulate
+ * @return TRACE_END after the last record, TRACE_FORMAT_ERROR if the trace stopped at a bad line
+ */
+TRACE_STATUS CacheSimulator::feed(TraceSource& source){
+    TraceRecord record;
+    TRACE_STATUS status;
+    while ((status = source.next(record)) == TRACE_RECORD)
+        feed(record);
+    return status;
+}
+
+/**
+ * @return the access, miss, writeback, eviction and traffic counters and the cycles so far, every other counter 0
+ */
+CacheStats CacheSimulator::counters() const{
+    CacheStats stats = CacheStats();
+    if (wide != NULL){
+        stats.l1accesses = wide->l1accesses;
+        stats.l1Misses = wide->l1Misses;
+        stats.l2Misses = wide->l2Misses;
+        stats.l1Writebacks = wide->l1Writebacks;
+        stats.l2Writebacks = wide->l2Writebacks;
+        stats.l1Evictions = wide->l1Evictions;
+        stats.l2Evictions = wide->l2Evictions;
+        stats.fetchedBytes = wide->fetchedBytes;
+        stats.writtenBytes = wide->writtenBytes;
+        stats.savedBytes = wide->savedBytes;
+        stats.totalCycles = wide->totalCycles();
+    }
+    else {
+        stats.l1accesses = narrow->l1accesses;
+        stats.l1Misses = narrow->l1Misses;
+        stats.l2Misses = narrow->l2Misses;
+        stats.l1Writebacks = narrow->l1Writebacks;
+        stats.l2Writebacks = narrow->l2Writebacks;
+        stats.l1Evictions = narrow->l1Evictions;
+        stats.l2Evictions = narrow->l2Evictions;
+        stats.fetchedBytes = narrow->fetchedBytes;
+        stats.writtenBytes = narrow->writtenBytes;
+        stats.savedBytes = narrow->savedBytes;
+        stats.totalCycles = narrow->totalCycles();
+    }
+    if (timing != NULL)
+        stats.totalCycles = timing->totalLatency;
+    if (tlb != NULL)
+        stats.totalCycles += tlb->cycles;
+    return stats;
+}
+
+/**
+ * @return the counters of the simulation so far
+ */
+CacheStats CacheSimulator::getStats() const{
+    CacheStats stats = counters();
+    MissClassifier* l1Classifier = wide != NULL ? wide->l1Classifier : narrow->l1Classifier;
+    MissClassifier* l2Classifier = wide != NULL ? wide->l2Classifier : narrow->l2Classifier;
+    if (timing != NULL){
+        stats.bankConflicts = timing->bankConflicts;
+        stats.bankWaitCycles = timing->bankWait;
+        stats.mshrWaitCycles = timing->mshrWait;
+        stats.l1MshrMerges = timing->l1Merges;
+        stats.l2MshrMerges = timing->l2Merges;
+    }
+    const WriteBuffer* writeBuffer = wide != NULL ? wide->writeBuffer : narrow->writeBuffer;
+    if (writeBuffer != NULL){
+        stats.bufferedWrites = writeBuffer->writes;
+        stats.coalescedWrites = writeBuffer->coalesced;
+        stats.bufferOccupancy = writeBuffer->occupancy;
+        stats.maxBufferOccupancy = writeBuffer->maxOccupancy;
+        stats.bufferStallCycles = writeBuffer->stallCycles;
+    }
+    const MemoryBackend* memory = wide != NULL ? wide->memory : narrow->memory;
+    if (memory != NULL){
+        stats.dramReads = memory->reads;
+        stats.dramWrites = memory->writebacks;
+    }
+    // only a DRAM backend has row buffers
+    const DramMemory* dram = dynamic_cast<const DramMemory*>(memory);
+    if (dram != NULL){
+        stats.rowHits = dram->rowHits;
+        stats.rowEmpty = dram->rowEmpty;
+        stats.rowConflicts = dram->rowConflicts;
+    }
+    const AdaptiveInsertion* insertion = wide != NULL ? wide->insertion : narrow->insertion;
+    if (insertion != NULL){
+        stats.psel = insertion->getPsel();
+        stats.lruLeaderMisses = insertion->lruLeaderMisses;
+        stats.bipLeaderMisses = insertion->bipLeaderMisses;
+        stats.lruInsertions = insertion->lruInsertions;
+        stats.bypasses = insertion->bypasses;
+    }
+    if (tlb != NULL){
+        stats.tlbAccesses = tlb->accesses;
+        stats.tlbL1Misses = tlb->l1Misses;
+        stats.tlbL2Misses = tlb->l2Misses;
+        stats.tlbOverflowPages = tlb->overflowPages;
+    }
+    stats.classified = l1Classifier != NULL;
+    if (stats.classified){
+        MissBreakdown l1 = {l1Classifier->compulsory, l1Classifier->capacity, l1Classifier->conflict};
+        MissBreakdown l2 = {l2Classifier->compulsory, l2Classifier->capacity, l2Classifier->conflict};
+        stats.l1Classes = l1;
+        stats.l2Classes = l2;
+    }
+    return stats;
+}
+
+/**
+ * @param trace number of a co-scheduled trace
+ * @return the access, miss, writeback, eviction and traffic counters and the cycles of the accesses of the trace, every
+ *         other counter 0
+ */
+CacheStats CacheSimulator::getTraceStats(unsigned int trace) const{
+    return traceStats[trace];
+}
+
+/**
+ * @return the misses and writebacks per region and PC, NULL unless the configuration asks for attribution
+ */
+const AccessAttribution* CacheSimulator::getAttribution() const{
+    return wide != NULL ? wide->attribution : narrow->attribution;
+}
+
+/**
+ * @return the L2 way masks and the occupancy of every trace, NULL unless the configuration partitions L2
+ */
+const WayPartition* CacheSimulator::getPartition() const{
+    return wide != NULL ? wide->partition : narrow->partition;
+}
+
+/**
+ * writes the cache state to a checkpoint file
+ * @param path checkpoint file to create
+ * @return true on success, false as well when the state has parts a checkpoint cannot hold
+ */
+bool CacheSimulator::saveState(const char* path){
+    if (!checkpointable())
+        return false;
+    return wide != NULL ? wide->saveState(path) : narrow->saveState(path);
+}
+
+/**
+ * replaces the cache state with a checkpoint of the same configuration, widening to 64 bit addresses first when
+ * the checkpoint was made by a 64 bit simulation
+ * @param path checkpoint file to read
+ * @return false if the file cannot be read or does not match the configuration
+ */
+bool CacheSimulator::loadState(const char* path){
+    if (!checkpointable())
+        return false;
+    if (narrow != NULL && checkpointAddressBits(path) == 64)
+        widen();
+    return wide != NULL ? wide->loadState(path) : narrow->loadState(path);
+}
+
+/**
+ * writes the per-set and per-way counters of both levels
+ * @param path file to create
+ * @param binary true for the binary layout, false for CSV
+ * @return false if the heatmap is off or the file could not be written
+ */
+bool CacheSimulator::dumpHeatmap(const char* path, bool binary) const{
+    const SetHeatmap* l1 = wide != NULL ? wide->l1Heatmap : narrow->l1Heatmap;
+    const SetHeatmap* l2 = wide != NULL ? wide->l2Heatmap : narrow->l2Heatmap;
+    if (l1 == NULL)
+        return false;
+    return dumpHeatmaps(path, binary, *l1, *l2);
+}
+
+/**
+ * writes the per-set counters of both levels to a stream, such as the one of the report
+ * @param out stream to write to
+ * @param binary true for the binary layout, false for CSV
+ * @return false if the heatmap is not enabled or the stream could not be written
+ */
+bool CacheSimulator::dumpHeatmap(FILE* out, bool binary) const{
+    const SetHeatmap* l1 = wide != NULL ? wide->l1Heatmap : narrow->l1Heatmap;
+    const SetHeatmap* l2 = wide != NULL ? wide->l2Heatmap : narrow->l2Heatmap;
+    if (l1 == NULL)
+        return false;
+    return writeHeatmaps(out, binary, *l1, *l2);
+}
@@ -0,0 +1,170 @@
+//
+// Library interface of the cache simulator: a two level cache fed one access (or one trace) at a time.
+//
+
+#ifndef CACHE_SIMULATOR_H
+#define CACHE_SIMULATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cache.h"
+#include "traceReader.h"
+#include "tlb.h"
+#include "timing.h"
+
+/**
+ * the geometry and timing of a simulated cache, sizes are log2 of bytes and associativities log2 of ways
+ */
+struct CacheConfig{
+    unsigned int memCyc;
+    unsigned int bSize;
+    unsigned int wrAllocate;
+    unsigned int l1Size;
+    unsigned int l1Assoc;
+    unsigned int l1Cyc;
+    unsigned int l2Size;
+    unsigned int l2Assoc;
+    unsigned int l2Cyc;
+    unsigned int sectors;       // log2 of the sectors of a line, 0 keeps whole lines
+    bool l1WriteThrough;        // stores go through a coalescing write buffer to L2 instead of dirtying L1
+    unsigned int writeBuffer;   // entries of the write buffer, at most WRITE_BUFFER_MAX
+    unsigned int writeBufferCyc;    // cycles to drain an entry to L2, 0 uses the L2 latency
+    INDEX_FUNCTION l1Index;     // set index function of every level, BIT_SELECT takes the low block number bits
+    INDEX_FUNCTION l2Index;
+    INSERTION_POLICY l2Insertion;   // where L2 inserts a missing block, LRU_INSERTION puts it at MRU
+    bool l2Bypass;              // leave the blocks predicted dead out of L2
+    unsigned int bypassRegionBits;  // log2 of the bytes of a region of the dead block predictor
+    unsigned int traces;        // co-scheduled traces, each on a core with a private L1 in front of the shared L2
+    vector<vector<uint64_t> > wayMasks;     // L2 ways every trace may fill, per interval, empty to fill any way
+    unsigned long long repartitionInterval; // accesses between the partitionings of wayMasks
+    unsigned int addressBits;   // 32 or 64, a 32 bit simulation widens itself on the first wider address
+    bool classifyMisses;        // keep the compulsory / capacity / conflict breakdown
+    bool attribute;             // count misses and writebacks per address region and per PC
+    unsigned int regionBits;    // log2 of the size of an attribution region
+    unsigned int attributionSlots;  // regions (and PCs) the attribution tables can hold
+    bool heatmap;               // per-set and per-way counters, needs a build with CACHE_HEATMAP
+    TlbConfig tlb;              // translation in front of the caches, off unless tlb.enabled
+    TimingConfig timing;        // latencies with contention and queuing, off unless timing.enabled
+    DramConfig dram;            // DRAM below L2 instead of the flat memCyc, off unless dram.enabled
+    CacheConfig() : memCyc(0), bSize(0), wrAllocate(0), l1Size(0), l1Assoc(0), l1Cyc(0), l2Size(0), l2Assoc(0),
+                    l2Cyc(0), sectors(0), l1WriteThrough(false), writeBuffer(8),
+                    writeBufferCyc(0), l1Index(BIT_SELECT), l2Index(BIT_SELECT),
+                    l2Insertion(LRU_INSERTION), l2Bypass(false), bypassRegionBits(12),
+                    traces(1), repartitionInterval(0), addressBits(32), classifyMisses(false), attribute(false), regionBits(12),
+                    attributionSlots(4096), heatmap(false){}
+};
+
+/**
+ * the three C's of the misses of one level
+ */
+struct MissBreakdown{
+    unsigned long long compulsory;
+    unsigned long long capacity;
+    unsigned long long conflict;
+};
+
+/**
+ * the counters of a simulation and the statistics derived from them
+ */
+struct CacheStats{
+    unsigned long long l1accesses;
+    unsigned long long l1Misses;
+    unsigned long long l2Misses;
+    unsigned long long l1Writebacks;
+    unsigned long long l2Writebacks;
+    unsigned long long l1Evictions;     // valid lines replaced by a fill
+    unsigned long long l2Evictions;
+    unsigned long long fetchedBytes;    // memory traffic of the L2 fills and writebacks
+    unsigned long long writtenBytes;
+    unsigned long long savedBytes;      // traffic sectored lines avoided
+    unsigned long long bufferedWrites;  // write-through L1: stores through the write buffer
+    unsigned long long coalescedWrites;
+    unsigned long long bufferOccupancy; // sum of the entries every store found
+    unsigned int maxBufferOccupancy;
+    unsigned long long bufferStallCycles;
+    unsigned int psel;          // L2 insertion: the dueling counter, above half the followers insert bimodally
+    unsigned long long lruLeaderMisses;
+    unsigned long long bipLeaderMisses;
+    unsigned long long lruInsertions;   // blocks L2 inserted at the LRU position
+    unsigned long long bypasses;        // blocks left out of L2
+    unsigned long long tlbAccesses;
+    unsigned long long tlbL1Misses;
+    unsigned long long tlbL2Misses;
+    unsigned long long tlbOverflowPages;    // pages touched after physical memory was used up
+    unsigned long long bankConflicts;   // timing mode: L2 accesses that found their bank busy
+    unsigned long long bankWaitCycles;
+    unsigned long long mshrWaitCycles;
+    unsigned long long l1MshrMerges;    // timing mode: misses to a block in flight that waited for it
+    unsigned long long l2MshrMerges;
+    unsigned long long dramReads;       // DRAM backend: L2 misses and L2 writebacks that reached the DRAM
+    unsigned long long dramWrites;
+    unsigned long long rowHits;
+    unsigned long long rowEmpty;
+    unsigned long long rowConflicts;
+    unsigned long long totalCycles;     // includes the TLB lookups and page walks, and queuing in timing mode
+    bool classified;            // l1Classes and l2Classes are only set when misses are classified
+    MissBreakdown l1Classes;
+    MissBreakdown l2Classes;
+    double getL1MissRate() const{
+        return double(l1Misses)/double(l1accesses);
+    }
+    double getL2MissRate() const{
+        return double(l2Misses)/double(l1Misses);
+    }
+    double accTimeAVG() const{
+        return double(totalCycles) / double(l1accesses);
+    }
+};
+
+/**
+ * a cache simulation that is fed with accesses as they come, so it can be driven by a trace file, a pipe or
+ * another program without a process per run
+ */
+class CacheSimulator{
+    const CacheConfig config;
+    Cache<uint32_t>* narrow;
+    Cache<uint64_t>* wide;
+    Tlb* tlb;
+    TimingModel* timing;
+    vector<CacheStats> traceStats;  // per co-scheduled trace
+
+    void widen();
+    CacheStats counters() const;
+    void simulate(uint64_t address, OPERATION op);
+public:
+    explicit CacheSimulator(const CacheConfig& config);
+    ~CacheSimulator();
+    CacheSimulator(const CacheSimulator&) = delete;
+    CacheSimulator& operator=(const CacheSimulator&) = delete;
+    void feed(uint64_t address, OPERATION op);
+    void feed(const TraceRecord& record);
+    void feed(const TraceRecord& record, unsigned int trace);
+    void feed(const TraceRecord* records, size_t count);
+    TRACE_STATUS feed(TraceSource& source);
+    CacheStats getStats() const;
+    CacheStats getTraceStats(unsigned int trace) const;
+    const AccessAttribution* getAttribution() const;
+    const WayPartition* getPartition() const;
+    const CacheConfig& getConfig() const{
+        return config;
+    }
+    unsigned int getAddressBits() const{
+        return wide != NULL ? 64 : 32;
+    }
+    /**
+     * @return false when sector masks, DRAM state, a write buffer, insertion state, private L1s or way partitions
+     *         are simulated or sets are hashed, checkpoints only hold whole lines of bit selected sets of one L1
+     *         and L2
+     */
+    bool checkpointable() const{
+        return config.sectors == 0 && !config.dram.enabled && config.l1Index == BIT_SELECT &&
+               config.l2Index == BIT_SELECT && !config.l1WriteThrough && config.l2Insertion == LRU_INSERTION &&
+               !config.l2Bypass && config.traces == 1 && config.wayMasks.empty();
+    }
+    bool saveState(const char* path);
+    bool loadState(const char* path);
+    bool dumpHeatmap(const char* path, bool binary) const;
+    bool dumpHeatmap(FILE* out, bool binary) const;
+};
+
+#endif // CACHE_SIMULATOR_H
@@ -0,0 +1,243 @@
+//
+// Binary checkpoints of the complete cache state, for warm-start simulations.
+//
+
+#include <vector>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "checkpoint.h"
+
+using namespace std;
+
+/*
+ * Checkpoint layout (native byte order, every field naturally aligned so the file can be used in place once mapped):
+ *   CheckpointHeader
+ *   per hierarchy (L1 then L2), at the offsets given in its CheckpointLevel:
+ *     CheckpointSet[numSets]        set key and number of entries, in ascending set order
+ *     CheckpointEntry[numEntries]   entries of all sets one after the other, MRU first inside a set
+ * entries hold 32 bit addresses (8 bytes per entry) unless the cache was simulating 64 bit addresses.
+ */
+
+static const char CHECKPOINT_MAGIC[8] = {'C', 'S', 'I', 'M', 'C', 'K', 'P', 'T'};
+static const uint32_t CHECKPOINT_VERSION = 5;
+static const uint32_t CHECKPOINT_VALID = 1;
+static const uint32_t CHECKPOINT_DIRTY = 2;
+
+struct CheckpointLevel{
+    uint32_t numOfSetBits;
+    uint32_t lAssoc;
+    uint32_t lCyc;
+    uint32_t numSets;
+    uint64_t setsOffset;
+    uint64_t entriesOffset;
+    uint64_t writebacks;
+    uint64_t evictions;
+    uint32_t numEntries;
+};
+
+struct CheckpointHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    int32_t memCyc;
+    uint32_t bSize;
+    uint32_t wrAllocate;
+    uint32_t addressBits;
+    uint64_t l1accesses;
+    uint64_t l1Misses;
+    uint64_t l2Misses;
+    uint64_t fetchedBytes;
+    uint64_t writtenBytes;
+    uint64_t savedBytes;
+    CheckpointLevel levels[2];
+};
+
+struct CheckpointSet{
+    int32_t set;
+    uint32_t count;
+};
+
+template <typename Addr>
+struct CheckpointEntry{
+    Addr address;
+    uint32_t flags;
+};
+
+/**
+ * appends the sets and entries of a hierarchy to a checkpoint image and fills its level descriptor
+ * @param hierarchy hierarchy to serialize
+ * @param writebacks number of dirty evictions out of the hierarchy so far
+ * @param evictions number of lines the hierarchy replaced so far
+ * @param level descriptor to fill
+ * @param image checkpoint image
+ */
+template <typename Addr>
+static void checkpointLevel(const CacheHierarchy<Addr>& hierarchy, unsigned long long writebacks,
+                            unsigned long long evictions, CheckpointLevel& level, vector<char>& image){
+    vector<CheckpointSet> sets;
+    vector<CheckpointEntry<Addr> > entries;
+    typename map<int, list<Entry<Addr> > >::const_iterator set;
+    for (set = hierarchy.L.begin(); set != hierarchy.L.end(); ++set){
+        if (set->second.empty())
+            continue;   // snoop creates empty sets on lookups
+        CheckpointSet record = {set->first, (uint32_t)set->second.size()};
+        sets.push_back(record);
+        typename list<Entry<Addr> >::const_iterator it;
+        for (it = set->second.begin(); it != set->second.end(); ++it){
+            CheckpointEntry<Addr> entry = {it->address, (it->validBit ? CHECKPOINT_VALID : 0) |
+                                                  (it->dirtyBit ? CHECKPOINT_DIRTY : 0)};
+            entries.push_back(entry);
+        }
+    }
+    level.numOfSetBits = hierarchy.numOfSetBits;
+    level.lAssoc = hierarchy.lAssoc;
+    level.lCyc = hierarchy.lCyc;
+    level.numSets = sets.size();
+    level.numEntries = entries.size();
+    level.writebacks = writebacks;
+    level.evictions = evictions;
+    level.setsOffset = image.size();
+    image.insert(image.end(), (const char*)sets.data(), (const char*)(sets.data() + sets.size()));
+    level.entriesOffset = image.size();
+    image.insert(image.end(), (const char*)entries.data(), (const char*)(entries.data() + entries.size()));
+}
+
+/**
+ * rebuilds the sets of a hierarchy from a mapped checkpoint
+ * @param hierarchy hierarchy the checkpoint should match
+ * @param level descriptor of the hierarchy inside the checkpoint
+ * @param image start of the mapped checkpoint
+ * @param size size of the checkpoint in bytes
+ * @param L filled with the restored sets
+ * @return false if the descriptor does not match the geometry of the hierarchy or points outside the checkpoint
+ */
+template <typename Addr>
+static bool restoreLevel(const CacheHierarchy<Addr>& hierarchy, const CheckpointLevel& level, const char* image,
+                         size_t size, map<int, list<Entry<Addr> > >& L){
+    if (level.numOfSetBits != hierarchy.numOfSetBits || level.lAssoc != hierarchy.lAssoc)
+        return false;
+    if (level.setsOffset + (uint64_t)level.numSets * sizeof(CheckpointSet) > size ||
+        level.entriesOffset + (uint64_t)level.numEntries * sizeof(CheckpointEntry<Addr>) > size)
+        return false;
+    const CheckpointSet* sets = (const CheckpointSet*)(image + level.setsOffset);
+    const CheckpointEntry<Addr>* entries = (const CheckpointEntry<Addr>*)(image + level.entriesOffset);
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < level.numSets; i++){
+        if (sets[i].count > (1u << hierarchy.lAssoc) || sets[i].count > level.numEntries - next)
+            return false;
+        list<Entry<Addr> >& set = L[sets[i].set];
+        for (uint32_t j = 0; j < sets[i].count; j++, next++)
+            set.push_back(Entry<Addr>(entries[next].address, entries[next].flags & CHECKPOINT_DIRTY,
+                                entries[next].flags & CHECKPOINT_VALID, j));
+    }
+    return true;
+}
+
+/**
+ * writes the complete cache state (entries, LRU order and counters) to a checkpoint file
+ * @param path checkpoint file to create
+ * @return true on success
+ */
+template <typename Addr>
+bool Cache<Addr>::saveState(const char* path){
+    vector<char> image(sizeof(CheckpointHeader));
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.headerSize = sizeof(CheckpointHeader);
+    header.memCyc = memCyc;
+    header.bSize = bSize;
+    header.wrAllocate = wrAllocate;
+    header.addressBits = sizeof(Addr) * 8;
+    header.l1accesses = l1accesses;
+    header.l1Misses = l1Misses;
+    header.l2Misses = l2Misses;
+    header.fetchedBytes = fetchedBytes;
+    header.writtenBytes = writtenBytes;
+    header.savedBytes = savedBytes;
+    checkpointLevel(l1, l1Writebacks, l1Evictions, header.levels[0], image);
+    checkpointLevel(l2, l2Writebacks, l2Evictions, header.levels[1], image);
+    memcpy(image.data(), &header, sizeof(header));
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+        return false;
+    bool ok = fwrite(image.data(), 1, image.size(), file) == image.size();
+    return fclose(file) == 0 && ok;
+}
+
+/**
+ * replaces the cache state with the one stored in a checkpoint file made by a cache of the same geometry, the
+ * latencies may differ since they do not change the content of the cache
+ * @param path checkpoint file to read
+ * @return false if the file cannot be read, is not a checkpoint or was made with a different geometry
+ */
+template <typename Addr>
+bool Cache<Addr>::loadState(const char* path){
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(CheckpointHeader)){
+        close(fd);
+        return false;
+    }
+    size_t size = info.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    const char* image = (const char*)mapping;
+    const CheckpointHeader* header = (const CheckpointHeader*)image;
+    map<int, list<Entry<Addr> > > l1Sets, l2Sets;
+    bool ok = memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) == 0 &&
+              header->version == CHECKPOINT_VERSION && header->headerSize == sizeof(CheckpointHeader) &&
+              header->bSize == bSize && header->wrAllocate == wrAllocate &&
+              header->addressBits == sizeof(Addr) * 8 &&
+              restoreLevel(l1, header->levels[0], image, size, l1Sets) &&
+              restoreLevel(l2, header->levels[1], image, size, l2Sets);
+    if (ok){
+        l1.L.swap(l1Sets);
+        l2.L.swap(l2Sets);
+        l1accesses = header->l1accesses;
+        l1Misses = header->l1Misses;
+        l2Misses = header->l2Misses;
+        fetchedBytes = header->fetchedBytes;
+        writtenBytes = header->writtenBytes;
+        savedBytes = header->savedBytes;
+        l1Writebacks = header->levels[0].writebacks;
+        l2Writebacks = header->levels[1].writebacks;
+        l1Evictions = header->levels[0].evictions;
+        l2Evictions = header->levels[1].evictions;
+    }
+    munmap(mapping, size);
+    return ok;
+}
+
+/**
+ * @param path checkpoint file
+ * @return the address width (32 or 64) the checkpoint was made with, 0 if it is not a readable checkpoint
+ */
+unsigned int checkpointAddressBits(const char* path){
+    CheckpointHeader header;
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+        return 0;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == CHECKPOINT_VERSION;
+    fclose(file);
+    return ok ? header.addressBits : 0;
+}
+
+template bool Cache<uint32_t>::saveState(const char* path);
+template bool Cache<uint64_t>::saveState(const char* path);
+template bool Cache<uint32_t>::loadState(const char* path);
+template bool Cache<uint64_t>::loadState(const char* path);
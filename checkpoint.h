@@ -0,0 +1,10 @@
+//
+// Binary checkpoints of the complete cache state, for warm-start simulations.
+//
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+unsigned int checkpointAddressBits(const char* path);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,166 @@
+//
+// Configuration files and named presets, turned into the options of the cacheSim command line.
+//
+
+#include <fstream>
+#include "configFile.h"
+
+/**
+ * a named configuration of the hierarchy, in command line options
+ */
+struct Preset{
+    const char* name;
+    const char* options;
+};
+
+static const Preset PRESETS[] = {
+    {"example1", "--mem-cyc 100 --bsize 3 --wr-alloc 1 --l1-size 4 --l1-assoc 1 --l1-cyc 1 --l2-size 6 "
+                 "--l2-assoc 0 --l2-cyc 5"},
+    {"example2", "--mem-cyc 50 --bsize 4 --wr-alloc 1 --l1-size 6 --l1-assoc 1 --l1-cyc 2 --l2-size 8 "
+                 "--l2-assoc 2 --l2-cyc 4"},
+    {"example3", "--mem-cyc 10 --bsize 2 --wr-alloc 1 --l1-size 4 --l1-assoc 1 --l1-cyc 1 --l2-size 4 "
+                 "--l2-assoc 2 --l2-cyc 5"},
+    // 8KB direct mapped L1 and 64KB 4-way L2 of 32 byte lines, no write allocate
+    {"embedded", "--mem-cyc 60 --bsize 5 --wr-alloc 0 --l1-size 13 --l1-assoc 0 --l1-cyc 1 --l2-size 16 "
+                 "--l2-assoc 2 --l2-cyc 8"},
+    // 32KB 8-way L1 and 256KB 4-way L2 of 64 byte lines
+    {"desktop", "--mem-cyc 200 --bsize 6 --wr-alloc 1 --l1-size 15 --l1-assoc 3 --l1-cyc 4 --l2-size 18 "
+                "--l2-assoc 2 --l2-cyc 12"},
+    // 32KB 8-way L1 and 1MB 16-way L2 of 64 byte lines
+    {"server", "--mem-cyc 250 --bsize 6 --wr-alloc 1 --l1-size 15 --l1-assoc 3 --l1-cyc 5 --l2-size 20 "
+               "--l2-assoc 4 --l2-cyc 14"},
+};
+
+// the options every simulation needs, from the command line, a configuration file or a preset
+static const char* const REQUIRED_OPTIONS[] = {"--mem-cyc", "--bsize", "--wr-alloc", "--l1-size", "--l1-assoc",
+                                               "--l1-cyc", "--l2-size", "--l2-assoc", "--l2-cyc"};
+
+/**
+ * @return text without the blanks around it
+ */
+static string trim(const string& text){
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == string::npos)
+        return "";
+    return text.substr(begin, text.find_last_not_of(" \t\r") + 1 - begin);
+}
+
+/**
+ * reads a configuration file. every "key = value" line is an option, "[section]" lines make the section the
+ * prefix of the keys that follow it, so "size = 15" under "[l1]" is --l1-size 15, and keys before any section or
+ * under "[cache]" are options as they are. '#' and ';' start comments, a value may be quoted. values are read as
+ * on the command line, so "index = skew" under "[l2]" chooses a policy by its name as --l2-index skew does.
+ * @param path file to read
+ * @param options the options and their values are appended to it
+ * @param origins the file and line of every option are appended to it
+ * @param error set when the file cannot be read or has a line that is not a section or a key
+ * @return false on error
+ */
+bool readConfigFile(const char* path, vector<string>& options, vector<string>& origins, string& error){
+    ifstream in(path);
+    if (!in){
+        error = string("Cannot open the configuration file ") + path;
+        return false;
+    }
+    string line, prefix;
+    for (unsigned int number = 1; getline(in, line); number++){
+        string where = string(path) + ":" + to_string(number);
+        size_t comment = line.find_first_of("#;");
+        line = trim(line.substr(0, comment));
+        if (line.empty())
+            continue;
+        if (line[0] == '['){
+            if (line[line.size() - 1] != ']'){
+                error = where + ": unterminated section " + line;
+                return false;
+            }
+            string section = trim(line.substr(1, line.size() - 2));
+            prefix = section.empty() || section == "cache" ? "" : section + "-";
+            continue;
+        }
+        size_t equals = line.find('=');
+        string key = trim(line.substr(0, equals)), value = equals == string::npos ? "" : trim(line.substr(equals + 1));
+        if (value.size() >= 2 && value[0] == '"' && value[value.size() - 1] == '"')
+            value = value.substr(1, value.size() - 2);
+        if (equals == string::npos || key.empty() || value.empty()){
+            error = where + ": expected key = value, got " + line;
+            return false;
+        }
+        options.push_back("--" + prefix + key);
+        options.push_back(value);
+        origins.push_back(where);
+    }
+    return true;
+}
+
+/**
+ * @param name name of a preset
+ * @param options the options of the preset and their values are appended to it
+ * @param origins "preset <name>" is appended to it for every option
+ * @return false if there is no such preset
+ */
+bool presetOptions(const string& name, vector<string>& options, vector<string>& origins){
+    for (unsigned int i = 0; i < sizeof(PRESETS) / sizeof(PRESETS[0]); i++){
+        if (name != PRESETS[i].name)
+            continue;
+        string text = PRESETS[i].options;
+        for (size_t begin = 0, end; begin < text.size(); begin = end + 1){
+            end = text.find(' ', begin);
+            if (end == string::npos)
+                end = text.size();
+            options.push_back(text.substr(begin, end - begin));
+            if (options.size() % 2 == 0)
+                origins.push_back("preset " + name);
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * gathers the options of a run: those of --preset first, then those of --config, then the command line itself, so
+ * an option given later overrides an earlier one
+ * @param argc number of arguments
+ * @param argv arguments, the options start at argv[2]
+ * @param options filled with option and value pairs
+ * @param origins filled with where every pair comes from
+ * @param error set for an option without a value, an unknown preset or a configuration file that cannot be read
+ * @return false on error
+ */
+bool collectOptions(int argc, char** argv, vector<string>& options, vector<string>& origins, string& error){
+    if (argc > 2 && argc % 2 != 0){
+        error = string("Option ") + argv[argc - 1] + " has no value (command line)";
+        return false;
+    }
+    for (int i = 2; i + 1 < argc; i += 2){
+        if (string(argv[i]) == "--preset" && !presetOptions(argv[i + 1], options, origins)){
+            error = string("Unknown preset ") + argv[i + 1];
+            return false;
+        }
+    }
+    for (int i = 2; i + 1 < argc; i += 2){
+        if (string(argv[i]) == "--config" && !readConfigFile(argv[i + 1], options, origins, error))
+            return false;
+    }
+    for (int i = 2; i + 1 < argc; i += 2){
+        options.push_back(argv[i]);
+        options.push_back(argv[i + 1]);
+        origins.push_back("command line");
+    }
+    return true;
+}
+
+/**
+ * @param options option and value pairs
+ * @return the first option every simulation needs that is not among options, NULL if none is missing
+ */
+const char* missingOption(const vector<string>& options){
+    for (unsigned int i = 0; i < sizeof(REQUIRED_OPTIONS) / sizeof(REQUIRED_OPTIONS[0]); i++){
+        bool given = false;
+        for (unsigned int j = 0; j < options.size() && !given; j += 2)
+            given = options[j] == REQUIRED_OPTIONS[i];
+        if (!given)
+            return REQUIRED_OPTIONS[i];
+    }
+    return NULL;
+}
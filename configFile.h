@@ -0,0 +1,18 @@
+//
+// Configuration files and named presets, turned into the options of the cacheSim command line.
+//
+
+#ifndef CONFIG_FILE_H
+#define CONFIG_FILE_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+bool readConfigFile(const char* path, vector<string>& options, vector<string>& origins, string& error);
+bool presetOptions(const string& name, vector<string>& options, vector<string>& origins);
+bool collectOptions(int argc, char** argv, vector<string>& options, vector<string>& origins, string& error);
+const char* missingOption(const vector<string>& options);
+
+#endif // CONFIG_FILE_H
@@ -0,0 +1,84 @@
+//
+// Per-set and per-way utilization counters of a cache level, dumped as a CSV or binary heatmap.
+//
+
+#include "heatmap.h"
+
+/*
+ * Binary heatmap layout (native byte order):
+ *   char magic[8] "CSIMHEAT", uint32_t version, uint32_t levels
+ *   per level (L1 then L2):
+ *     uint32_t sets, uint32_t ways
+ *     uint64_t accesses[sets], misses[sets], evictions[sets]
+ *     uint64_t wayHits[sets * ways]    hits of every set, most recently used way first
+ */
+
+static const char HEATMAP_MAGIC[8] = {'C', 'S', 'I', 'M', 'H', 'E', 'A', 'T'};
+static const uint32_t HEATMAP_VERSION = 1;
+
+/**
+ * prints a row per set: level, set, accesses, misses, evictions and the hits of every way
+ * @param out stream to print to
+ * @param level name of the level in the first column
+ */
+void SetHeatmap::printCSV(FILE* out, const char* level) const{
+    for (size_t set = 0; set < accesses.size(); set++){
+        fprintf(out, "%s,%zu,%llu,%llu,%llu", level, set, accesses[set], misses[set], evictions[set]);
+        for (unsigned int way = 0; way < ways; way++)
+            fprintf(out, ",%llu", wayHits[set * ways + way]);
+        fprintf(out, "\n");
+    }
+}
+
+/**
+ * writes the counters of the level in the binary layout
+ * @param out stream to write to
+ */
+void SetHeatmap::write(FILE* out) const{
+    uint32_t shape[2] = {(uint32_t)accesses.size(), ways};
+    fwrite(shape, sizeof(shape), 1, out);
+    fwrite(accesses.data(), sizeof(unsigned long long), accesses.size(), out);
+    fwrite(misses.data(), sizeof(unsigned long long), misses.size(), out);
+    fwrite(evictions.data(), sizeof(unsigned long long), evictions.size(), out);
+    fwrite(wayHits.data(), sizeof(unsigned long long), wayHits.size(), out);
+}
+
+/**
+ * writes the heatmaps of both levels to a stream
+ * @param out stream to write to
+ * @param binary true for the binary layout, false for CSV with a header line
+ * @param l1 counters of L1
+ * @param l2 counters of L2
+ * @return false if the stream could not be written
+ */
+bool writeHeatmaps(FILE* out, bool binary, const SetHeatmap& l1, const SetHeatmap& l2){
+    if (binary){
+        uint32_t header[2] = {HEATMAP_VERSION, 2};
+        fwrite(HEATMAP_MAGIC, sizeof(HEATMAP_MAGIC), 1, out);
+        fwrite(header, sizeof(header), 1, out);
+        l1.write(out);
+        l2.write(out);
+    }
+    else {
+        fprintf(out, "level,set,accesses,misses,evictions,wayHits...\n");
+        l1.printCSV(out, "L1");
+        l2.printCSV(out, "L2");
+    }
+    return !ferror(out);
+}
+
+/**
+ * writes the heatmaps of both levels to a file
+ * @param path file to create
+ * @param binary true for the binary layout, false for CSV with a header line
+ * @param l1 counters of L1
+ * @param l2 counters of L2
+ * @return false if the file could not be written
+ */
+bool dumpHeatmaps(const char* path, bool binary, const SetHeatmap& l1, const SetHeatmap& l2){
+    FILE* out = fopen(path, binary ? "wb" : "w");
+    if (out == NULL)
+        return false;
+    bool ok = writeHeatmaps(out, binary, l1, l2);
+    return fclose(out) == 0 && ok;
+}
@@ -0,0 +1,47 @@
+//
+// Per-set and per-way utilization counters of a cache level, dumped as a CSV or binary heatmap.
+//
+
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ * the counters of one level in flat arrays indexed by set, parallel to the sets of the hierarchy. ways are LRU
+ * positions (0 is the most recently used line), since the sets keep their lines in recency order and not in slots.
+ * the cache only updates them when the simulator is built with CACHE_HEATMAP.
+ */
+class SetHeatmap{
+    const unsigned int ways;
+    vector<unsigned long long> accesses;
+    vector<unsigned long long> misses;
+    vector<unsigned long long> evictions;
+    vector<unsigned long long> wayHits;     // sets x ways
+public:
+    SetHeatmap(unsigned int setBits, unsigned int assoc) : ways(1u << assoc), accesses(1ull << setBits, 0),
+            misses(1ull << setBits, 0), evictions(1ull << setBits, 0), wayHits((1ull << setBits) << assoc, 0){}
+    void access(uint64_t set){
+        accesses[set]++;
+    }
+    void miss(uint64_t set){
+        misses[set]++;
+    }
+    void eviction(uint64_t set){
+        evictions[set]++;
+    }
+    void hit(uint64_t set, unsigned int way){
+        wayHits[set * ways + way]++;
+    }
+    void printCSV(FILE* out, const char* level) const;
+    void write(FILE* out) const;
+};
+
+bool writeHeatmaps(FILE* out, bool binary, const SetHeatmap& l1, const SetHeatmap& l2);
+bool dumpHeatmaps(const char* path, bool binary, const SetHeatmap& l1, const SetHeatmap& l2);
+
+#endif // HEATMAP_H
@@ -0,0 +1,117 @@
+//
+// Adaptive insertion (DIP with set dueling) and dead-block bypass for L2.
+//
+
+#include "insertion.h"
+
+static const unsigned int PSEL_MAX = 1023;        // 10 bit selector
+static const unsigned int BIP_EPSILON = 32;
+static const unsigned int DEAD_TABLE_BITS = 12;
+static const uint8_t DEAD_MAX = 3;                // 2 bit counters, saturated means dead
+
+/**
+ * @param policy insertion policy of the missing blocks
+ * @param bypassing skip the allocation of blocks predicted dead
+ * @param regionBits log2 of the bytes of a region of the dead block table, used when the trace has no PCs
+ */
+AdaptiveInsertion::AdaptiveInsertion(INSERTION_POLICY policy, bool bypassing, unsigned int regionBits) :
+        policy(policy),
+        bypassing(bypassing),
+        regionBits(regionBits),
+        psel(PSEL_MAX / 2 + 1),
+        bimodalFills(0),
+        deadFills(0),
+        pc(0),
+        deadBlocks(bypassing ? 1u << DEAD_TABLE_BITS : 0, 0),
+        lruLeaderMisses(0),
+        bipLeaderMisses(0),
+        lruInsertions(0),
+        bypasses(0){}
+
+/**
+ * @param set set index
+ * @param setBits log2 of the number of sets
+ * @return the role of the set: the first set of every constituency leads LRU insertion and the last one leads
+ *         bimodal insertion, 32 constituencies in large caches and constituencies of 4 sets in small ones
+ */
+SET_POLICY AdaptiveInsertion::roleOf(uint64_t set, unsigned int setBits){
+    uint64_t sets = 1ull << setBits;
+    uint64_t group = sets >= 128 ? sets / 32 : sets >= 4 ? 4 : sets;
+    uint64_t offset = set % group;
+    if (group >= 2 && offset == 0)
+        return LRU_LEADER;
+    if (group >= 2 && offset == group - 1)
+        return BIP_LEADER;
+    return FOLLOWER_SET;
+}
+
+/**
+ * counts a miss of a set against its policy
+ * @param setMeta metadata of the set
+ */
+void AdaptiveInsertion::miss(uint8_t setMeta){
+    if ((setMeta & SET_POLICY_MASK) == LRU_LEADER){
+        lruLeaderMisses++;
+        if (psel < PSEL_MAX)
+            psel++;
+    }
+    else if ((setMeta & SET_POLICY_MASK) == BIP_LEADER){
+        bipLeaderMisses++;
+        if (psel > 0)
+            psel--;
+    }
+}
+
+/**
+ * @param setMeta metadata of the set the block goes to
+ * @return true to insert the block at MRU, false to insert it at LRU
+ */
+bool AdaptiveInsertion::insertAtMRU(uint8_t setMeta){
+    if (policy == LRU_INSERTION)
+        return true;
+    SET_POLICY role = SET_POLICY(setMeta & SET_POLICY_MASK);
+    bool bimodal = policy == BIP_INSERTION || role == BIP_LEADER || (role == FOLLOWER_SET && psel > PSEL_MAX / 2);
+    if (!bimodal || ++bimodalFills % BIP_EPSILON == 0)
+        return true;
+    lruInsertions++;
+    return false;
+}
+
+/**
+ * @param address block missing in L2
+ * @return the entry of the dead block table for the block: the hash of the current PC, or of the region of address
+ */
+uint16_t AdaptiveInsertion::signatureOf(uint64_t address) const{
+    uint64_t key = pc != 0 ? pc : address >> regionBits;
+    return (key * 0x9e3779b97f4a7c15ull) >> (64 - DEAD_TABLE_BITS);
+}
+
+/**
+ * @param signature of the block missing in L2
+ * @return true to leave the block out of L2
+ */
+bool AdaptiveInsertion::bypass(uint16_t signature){
+    if (!bypassing || deadBlocks[signature] < DEAD_MAX || ++deadFills % BIP_EPSILON == 0)
+        return false;
+    bypasses++;
+    return true;
+}
+
+/**
+ * trains the dead block table with an L2 hit
+ * @param signature the line that was hit was filled with
+ */
+void AdaptiveInsertion::reused(uint16_t signature){
+    if (bypassing && deadBlocks[signature] > 0)
+        deadBlocks[signature]--;
+}
+
+/**
+ * trains the dead block table with an L2 eviction
+ * @param signature the evicted line was filled with
+ * @param reused whether the line was hit while it was in L2
+ */
+void AdaptiveInsertion::evicted(uint16_t signature, bool reused){
+    if (bypassing && !reused && deadBlocks[signature] < DEAD_MAX)
+        deadBlocks[signature]++;
+}
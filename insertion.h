@@ -0,0 +1,67 @@
+//
+// Adaptive insertion (DIP with set dueling) and dead-block bypass for L2.
+//
+
+#ifndef INSERTION_H
+#define INSERTION_H
+
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+/*
+ * packed per-set metadata of a hierarchy, one byte per set: the low bits tag the role of the set in the duel
+ */
+enum SET_POLICY {FOLLOWER_SET = 0, LRU_LEADER = 1, BIP_LEADER = 2};
+static const uint8_t SET_POLICY_MASK = 3;
+
+/*
+ * where L2 inserts a missing block: always at MRU, bimodal (at LRU with an MRU insertion every BIP_EPSILON fills),
+ * or dynamic (set dueling between the two)
+ */
+enum INSERTION_POLICY {LRU_INSERTION, BIP_INSERTION, DIP_INSERTION};
+
+/**
+ * chooses where a block missing in L2 is inserted, and whether it is allocated at all.
+ * with dynamic insertion the leader sets always use LRU insertion or bimodal insertion, and their misses move a
+ * saturating PSEL counter. follower sets use the policy whose leaders miss less.
+ * with bypass on, a table of saturating counters learns whether the blocks filled by an instruction (or, without
+ * PCs in the trace, the blocks of an address region) are evicted without being reused. every line keeps the
+ * signature it was filled with to train the table, and blocks predicted dead are not allocated, except one in
+ * BIP_EPSILON to keep learning.
+ */
+class AdaptiveInsertion{
+    const INSERTION_POLICY policy;
+    const bool bypassing;
+    const unsigned int regionBits;
+    unsigned int psel;
+    unsigned int bimodalFills;
+    unsigned int deadFills;
+    uint64_t pc;
+    vector<uint8_t> deadBlocks;
+public:
+    unsigned long long lruLeaderMisses;
+    unsigned long long bipLeaderMisses;
+    unsigned long long lruInsertions;   // blocks inserted at the LRU position
+    unsigned long long bypasses;
+    AdaptiveInsertion(INSERTION_POLICY policy, bool bypassing, unsigned int regionBits);
+    static SET_POLICY roleOf(uint64_t set, unsigned int setBits);
+    unsigned int getPsel() const{
+        return psel;
+    }
+    /**
+     * @param pc instruction of the next access, 0 when the trace has no PC column
+     */
+    void setPC(uint64_t pc){
+        this->pc = pc;
+    }
+    void miss(uint8_t setMeta);
+    bool insertAtMRU(uint8_t setMeta);
+    uint16_t signatureOf(uint64_t address) const;
+    bool bypass(uint16_t signature);
+    void reused(uint16_t signature);
+    void evicted(uint16_t signature, bool reused);
+};
+
+#endif // INSERTION_H
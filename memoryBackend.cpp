@@ -0,0 +1,120 @@
+//
+// Memory backends below L2: a DRAM model with banks, row buffers and a request scheduler in place of --mem-cyc.
+//
+
+#include "memoryBackend.h"
+
+/**
+ * @param config organization, page policy and timings of the DRAM
+ */
+DramMemory::DramMemory(const DramConfig& config) : config(config),
+                                                   banks(1u << (config.channels + config.ranks + config.banks)),
+                                                   busFreeAt(1u << config.channels, 0),
+                                                   rowHits(0), rowEmpty(0), rowConflicts(0){}
+
+/**
+ * @param address physical address
+ * @param row set to the row of the address in its bank
+ * @return the index of the bank of the address, channel first, then rank, then bank
+ */
+unsigned int DramMemory::locate(uint64_t address, uint64_t& row) const{
+    uint64_t index = address >> config.rowBits;
+    unsigned int channel = index & ((1u << config.channels) - 1);
+    index >>= config.channels;
+    unsigned int bank = index & ((1u << config.banks) - 1);
+    index >>= config.banks;
+    unsigned int rank = index & ((1u << config.ranks) - 1);
+    row = index >> config.ranks;
+    return (channel << (config.ranks + config.banks)) | (rank << config.banks) | bank;
+}
+
+/**
+ * issues the commands of a request as soon as its bank is ready and moves its block over the channel
+ * @param address physical address of the request
+ * @param arrival cycle the request reaches the controller
+ * @return the cycle its last data is transferred
+ */
+unsigned long long DramMemory::serve(uint64_t address, unsigned long long arrival){
+    uint64_t row;
+    unsigned int index = locate(address, row);
+    Bank& bank = banks[index];
+    unsigned long long start = arrival > bank.readyAt ? arrival : bank.readyAt;
+    unsigned long long column;
+    if (bank.open && bank.openRow == row){
+        rowHits++;
+        column = start;
+    }
+    else if (!bank.open){
+        rowEmpty++;
+        column = start + config.tRCD;
+    }
+    else {
+        rowConflicts++;
+        column = start + config.tRP + config.tRCD;
+    }
+    unsigned long long& busFree = busFreeAt[index >> (config.ranks + config.banks)];
+    unsigned long long data = column + config.tCL;
+    if (busFree > data)
+        data = busFree;
+    busFree = data + config.tBurst;
+    if (config.policy == OPEN_PAGE){
+        bank.open = true;
+        bank.openRow = row;
+        bank.readyAt = column + config.tBurst;  // column commands to the open row are pipelined
+    }
+    else
+        bank.readyAt = busFree + config.tRP;    // precharged right after the transfer
+    return busFree;
+}
+
+/**
+ * serves the buffered writebacks that can start before a cycle, row buffer hits first and then the oldest
+ * @param until cycle the writebacks have to start before, all of them are served when it is the largest cycle
+ */
+void DramMemory::drain(unsigned long long until){
+    while (!writeQueue.empty()){
+        int pick = -1;
+        bool pickHit = false;
+        for (unsigned int i = 0; i < writeQueue.size() && !pickHit; i++){     // the queue is oldest first
+            uint64_t row;
+            const Bank& bank = banks[locate(writeQueue[i].address, row)];
+            unsigned long long start = writeQueue[i].arrival > bank.readyAt ? writeQueue[i].arrival : bank.readyAt;
+            if (start >= until)
+                continue;
+            bool hit = bank.open && bank.openRow == row;
+            if (pick < 0 || hit){
+                pick = i;
+                pickHit = hit;
+            }
+        }
+        if (pick < 0)
+            return;
+        serve(writeQueue[pick].address, writeQueue[pick].arrival);
+        writeQueue.erase(writeQueue.begin() + pick);
+    }
+}
+
+/**
+ * reads a block for an L2 miss, after the writebacks that fit before it
+ * @param address physical address of the miss
+ * @return the latency of the read
+ */
+unsigned long long DramMemory::access(uint64_t address){
+    reads++;
+    drain(now);
+    unsigned long long latency = serve(address, now) - now;
+    cycles += latency;
+    return latency;
+}
+
+/**
+ * buffers a dirty block evicted from L2, draining the whole queue once it is full
+ * @param address physical address of the block
+ */
+void DramMemory::writeback(uint64_t address){
+    writebacks++;
+    Request request = {address, now};
+    writeQueue.push_back(request);
+    if (writeQueue.size() >= config.writeQueue)
+        drain(~0ull);
+}
@@ -0,0 +1,86 @@
+//
+// Memory backends below L2: a DRAM model with banks, row buffers and a request scheduler in place of --mem-cyc.
+//
+
+#ifndef MEMORY_BACKEND_H
+#define MEMORY_BACKEND_H
+
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+enum PAGE_POLICY {OPEN_PAGE, CLOSED_PAGE};
+
+/**
+ * the organization and timing of the DRAM, counts are log2 and timings are in simulator cycles
+ */
+struct DramConfig{
+    bool enabled;
+    unsigned int channels;
+    unsigned int ranks;         // per channel
+    unsigned int banks;         // per rank
+    unsigned int rowBits;       // log2 of the bytes of a row, consecutive bytes of a row share its row buffer
+    PAGE_POLICY policy;         // open page keeps the row buffer after an access, closed page precharges at once
+    unsigned int tRCD;          // activate to column command
+    unsigned int tCL;           // column command to data
+    unsigned int tRP;           // precharge
+    unsigned int tBurst;        // cycles the data bus of a channel is busy per block
+    unsigned int writeQueue;    // writebacks buffered before they are drained
+    DramConfig() : enabled(false), channels(0), ranks(0), banks(3), rowBits(13), policy(OPEN_PAGE), tRCD(30), tCL(30),
+                   tRP(30), tBurst(8), writeQueue(16){}
+};
+
+/**
+ * a memory below L2 that replaces the flat --mem-cyc latency of the cache. the cache calls access on every L2 miss
+ * the access waits for and writeback on every dirty L2 eviction, which is posted and does not delay the access.
+ * requests arrive at the cycle in now, set by the owner of the clock before every access.
+ */
+class MemoryBackend{
+public:
+    unsigned long long now;
+    unsigned long long reads;
+    unsigned long long writebacks;
+    unsigned long long cycles;      // latency of all the accesses
+    MemoryBackend() : now(0), reads(0), writebacks(0), cycles(0){}
+    virtual ~MemoryBackend(){}
+    virtual unsigned long long access(uint64_t address) = 0;
+    virtual void writeback(uint64_t address) = 0;
+};
+
+/**
+ * DRAM with channels of ranks of banks. the low bits above the row offset choose the channel, then the bank and the
+ * rank, and the rest is the row, so a stream walks a whole row before it moves on.
+ * reads are served as they arrive, ahead of the buffered writebacks. the writebacks are scheduled first-ready
+ * first-come-first-served (FR-FCFS): among the ones that fit before the next read, or all of them once the queue is
+ * full, row buffer hits go first and the oldest request goes first among equals.
+ */
+class DramMemory : public MemoryBackend{
+    struct Bank{
+        uint64_t openRow;
+        bool open;
+        unsigned long long readyAt;     // cycle the bank takes its next command
+        Bank() : openRow(0), open(false), readyAt(0){}
+    };
+    struct Request{
+        uint64_t address;
+        unsigned long long arrival;
+    };
+    const DramConfig config;
+    vector<Bank> banks;
+    vector<unsigned long long> busFreeAt;   // per channel
+    vector<Request> writeQueue;
+
+    unsigned int locate(uint64_t address, uint64_t& row) const;
+    unsigned long long serve(uint64_t address, unsigned long long arrival);
+    void drain(unsigned long long until);
+public:
+    unsigned long long rowHits;
+    unsigned long long rowEmpty;
+    unsigned long long rowConflicts;
+    explicit DramMemory(const DramConfig& config);
+    unsigned long long access(uint64_t address);
+    void writeback(uint64_t address);
+};
+
+#endif // MEMORY_BACKEND_H
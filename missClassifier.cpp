@@ -0,0 +1,89 @@
+//
+// Three-C (compulsory / capacity / conflict) miss classification for a single cache hierarchy.
+//
+
+#include "missClassifier.h"
+
+/**
+ * detaches a node from the LRU list
+ * @param node index of the node to detach
+ */
+void ShadowCache::unlink(int node){
+    Node& n = nodes[node];
+    if (n.prev != -1)
+        nodes[n.prev].next = n.next;
+    else
+        head = n.next;
+    if (n.next != -1)
+        nodes[n.next].prev = n.prev;
+    else
+        tail = n.prev;
+}
+
+/**
+ * places a detached node at the MRU position
+ * @param node index of the node to place
+ */
+void ShadowCache::pushFront(int node){
+    nodes[node].prev = -1;
+    nodes[node].next = head;
+    if (head != -1)
+        nodes[head].prev = node;
+    head = node;
+    if (tail == -1)
+        tail = node;
+}
+
+/**
+ * looks up a block and updates the LRU order
+ * @param block block number (address without the offset bits)
+ * @param allocate whether a missing block should be brought into the cache
+ * @return true if the block was in the cache, false otherwise
+ */
+bool ShadowCache::access(uint64_t block, bool allocate){
+    unordered_map<uint64_t, int>::iterator it = index.find(block);
+    if (it != index.end()){
+        unlink(it->second);
+        pushFront(it->second);
+        return true;
+    }
+    if (!allocate || capacity == 0)
+        return false;
+    int node;
+    if (nodes.size() < capacity){
+        node = nodes.size();
+        nodes.push_back(Node());
+    }
+    else {  // reuse the LRU node for the new block
+        node = tail;
+        unlink(node);
+        index.erase(nodes[node].block);
+    }
+    nodes[node].block = block;
+    index[block] = node;
+    pushFront(node);
+    return false;
+}
+
+
+/**
+ * records an access to the hierarchy and classifies it if it missed
+ * @param address accessed address
+ * @param miss whether the real hierarchy missed on this access
+ * @param allocate whether the real hierarchy brings the block in on a miss
+ */
+void MissClassifier::access(uint64_t address, bool miss, bool allocate){
+    uint64_t block = address >> bSize;
+    bool shadowHit = shadow.access(block, allocate);
+    bool firstTouch = touched.find(block) == touched.end();
+    if (allocate && firstTouch)
+        touched.insert(block);
+    if (!miss)
+        return;
+    if (firstTouch)
+        compulsory++;
+    else if (!shadowHit)
+        capacity++;
+    else
+        conflict++;
+}
@@ -0,0 +1,60 @@
+//
+// Three-C (compulsory / capacity / conflict) miss classification for a single cache hierarchy.
+//
+
+#ifndef MISS_CLASSIFIER_H
+#define MISS_CLASSIFIER_H
+
+#include <vector>
+#include <stdint.h>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+/**
+ * a fully associative LRU cache that only tracks block numbers.
+ * the LRU order is kept in an intrusive doubly linked list whose nodes live in a flat vector, and a hash map
+ * points from a block number to its node, so every access is O(1) regardless of the capacity.
+ */
+class ShadowCache{
+    struct Node{
+        uint64_t block;
+        int prev;
+        int next;
+    };
+    vector<Node> nodes;
+    unordered_map<uint64_t, int> index;
+    int head;   // most recently used
+    int tail;   // least recently used
+    const unsigned int capacity;
+
+    void unlink(int node);
+    void pushFront(int node);
+public:
+    explicit ShadowCache(unsigned int capacity) : head(-1), tail(-1), capacity(capacity){
+        nodes.reserve(capacity);
+        index.reserve(capacity);
+    }
+    bool access(uint64_t block, bool allocate);
+};
+
+/**
+ * classifies the misses of one cache hierarchy into the three C's.
+ * a miss on a block that was never brought into the level is compulsory, a miss that a fully associative LRU
+ * cache of the same capacity would also take is a capacity miss, and every other miss is a conflict miss.
+ */
+class MissClassifier{
+    ShadowCache shadow;
+    unordered_set<uint64_t> touched;
+    const unsigned int bSize;
+public:
+    unsigned long long compulsory;
+    unsigned long long capacity;
+    unsigned long long conflict;
+    MissClassifier(unsigned int lSize, unsigned int bSize) : shadow(1u << (lSize - bSize)), bSize(bSize),
+                                                             compulsory(0), capacity(0), conflict(0){}
+    void access(uint64_t address, bool miss, bool allocate);
+};
+
+#endif // MISS_CLASSIFIER_H
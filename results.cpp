@@ -0,0 +1,258 @@
+//
+// Machine-readable results of a run: the configuration, every counter and the runtime as JSON, CSV or binary.
+//
+
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include "results.h"
+
+/*
+ * Binary results layout (native byte order), one self-contained record per run so runs can be appended to a file:
+ *   char magic[8] "CSIMRSLT", uint32_t version
+ *   uint32_t configFields, uint32_t counterFields, uint32_t rateFields, uint32_t traceLength
+ *   uint64_t config[configFields]      in the order of the CSV columns
+ *   uint64_t counters[counterFields]   in the order of the CSV columns
+ *   double rates[rateFields]           L1 and L2 miss rates, average access time, seconds and accesses per second,
+ *                                      the last two NaN when the runtime is left out, then the bounds of the 95%
+ *                                      confidence intervals of the three estimates, NaN unless the run is sampled
+ *   char trace[traceLength]            path of the trace, not terminated
+ */
+
+static const char RESULTS_MAGIC[8] = {'C', 'S', 'I', 'M', 'R', 'S', 'L', 'T'};
+static const uint32_t RESULTS_VERSION = 2;
+
+/**
+ * a named value of the record
+ */
+template <typename T>
+struct ResultField{
+    const char* name;
+    T value;
+};
+
+typedef ResultField<unsigned long long> Counter;
+typedef ResultField<double> Rate;
+
+/**
+ * @return the options of the run that change its counters
+ */
+static vector<Counter> configFields(const CacheConfig& config, const RunSummary& run){
+    const Sampler* sampler = run.sampler;
+    Counter fields[] = {
+            {"memCyc", config.memCyc}, {"bSize", config.bSize}, {"wrAllocate", config.wrAllocate},
+            {"l1Size", config.l1Size}, {"l1Assoc", config.l1Assoc}, {"l1Cyc", config.l1Cyc},
+            {"l2Size", config.l2Size}, {"l2Assoc", config.l2Assoc}, {"l2Cyc", config.l2Cyc},
+            {"sectors", config.sectors}, {"l1WriteThrough", config.l1WriteThrough},
+            {"writeBuffer", config.writeBuffer}, {"l1Index", config.l1Index}, {"l2Index", config.l2Index},
+            {"l2Insertion", config.l2Insertion}, {"l2Bypass", config.l2Bypass}, {"traces", config.traces},
+            {"addressBits", config.addressBits}, {"tlb", config.tlb.enabled}, {"timing", config.timing.enabled},
+            {"dram", config.dram.enabled}, {"setSample", sampler != NULL ? sampler->getSetSample() : 1},
+            {"samplePeriod", sampler != NULL ? sampler->getPeriod() : 0},
+            {"sampleWindow", sampler != NULL ? sampler->getWindow() : 0},
+            {"sampleWarmup", sampler != NULL ? sampler->getWarmup() : 0},
+            {"pageBits", config.tlb.pageBits}, {"tlb1Size", config.tlb.l1Size}, {"tlb1Assoc", config.tlb.l1Assoc},
+            {"tlb1Cyc", config.tlb.l1Cyc}, {"tlb2Size", config.tlb.l2Size}, {"tlb2Assoc", config.tlb.l2Assoc},
+            {"tlb2Cyc", config.tlb.l2Cyc}, {"walkCyc", config.tlb.walkCyc}, {"pageMap", config.tlb.mapping},
+            {"physBits", config.tlb.physBits}, {"l2Banks", config.timing.l2Banks},
+            {"l2BankCyc", config.timing.bankCyc}, {"l1Mshrs", config.timing.l1Mshrs},
+            {"l2Mshrs", config.timing.l2Mshrs}, {"dramChannels", config.dram.channels},
+            {"dramRanks", config.dram.ranks}, {"dramBanks", config.dram.banks}, {"dramRowBits", config.dram.rowBits},
+            {"dramPage", config.dram.policy}, {"tRCD", config.dram.tRCD}, {"tCL", config.dram.tCL},
+            {"tRP", config.dram.tRP}, {"tBurst", config.dram.tBurst}, {"dramWriteQueue", config.dram.writeQueue}};
+    return vector<Counter>(fields, fields + sizeof(fields) / sizeof(fields[0]));
+}
+
+/**
+ * @return every counter of the run, the ones of disabled features are 0. a sampled run gives the accesses, misses
+ * and cycles scaled back to the whole trace, the other counters only count the simulated records
+ */
+static vector<Counter> counterFields(const CacheStats& stats, const RunSummary& run){
+    unsigned long long accesses = stats.l1accesses, l1Misses = stats.l1Misses, l2Misses = stats.l2Misses;
+    unsigned long long cycles = stats.totalCycles, measured = stats.l1accesses;
+    if (run.sampler != NULL){
+        SampleEstimate sample = run.sampler->estimate();
+        double scaledMisses = sample.l1Miss * sample.records;
+        accesses = sample.records;
+        l1Misses = (unsigned long long)(scaledMisses + 0.5);
+        l2Misses = (unsigned long long)(sample.l2Miss * scaledMisses + 0.5);
+        cycles = (unsigned long long)(sample.accTime * sample.records + 0.5);
+        measured = sample.measured;
+    }
+    Counter fields[] = {
+            {"l1accesses", accesses}, {"l1Misses", l1Misses}, {"l2Misses", l2Misses}, {"measuredAccesses", measured},
+            {"l1Writebacks", stats.l1Writebacks}, {"l2Writebacks", stats.l2Writebacks},
+            {"l1Evictions", stats.l1Evictions}, {"l2Evictions", stats.l2Evictions},
+            {"fetchedBytes", stats.fetchedBytes}, {"writtenBytes", stats.writtenBytes},
+            {"savedBytes", stats.savedBytes}, {"totalCycles", cycles},
+            {"bufferedWrites", stats.bufferedWrites}, {"coalescedWrites", stats.coalescedWrites},
+            {"bufferOccupancy", stats.bufferOccupancy}, {"maxBufferOccupancy", stats.maxBufferOccupancy},
+            {"bufferStallCycles", stats.bufferStallCycles}, {"psel", stats.psel},
+            {"lruLeaderMisses", stats.lruLeaderMisses}, {"bipLeaderMisses", stats.bipLeaderMisses},
+            {"lruInsertions", stats.lruInsertions}, {"bypasses", stats.bypasses},
+            {"tlbAccesses", stats.tlbAccesses}, {"tlbL1Misses", stats.tlbL1Misses},
+            {"tlbL2Misses", stats.tlbL2Misses}, {"bankConflicts", stats.bankConflicts},
+            {"bankWaitCycles", stats.bankWaitCycles}, {"mshrWaitCycles", stats.mshrWaitCycles},
+            {"l1MshrMerges", stats.l1MshrMerges}, {"l2MshrMerges", stats.l2MshrMerges},
+            {"dramReads", stats.dramReads}, {"dramWrites", stats.dramWrites}, {"rowHits", stats.rowHits},
+            {"rowEmpty", stats.rowEmpty}, {"rowConflicts", stats.rowConflicts},
+            {"l1Compulsory", stats.classified ? stats.l1Classes.compulsory : 0},
+            {"l1Capacity", stats.classified ? stats.l1Classes.capacity : 0},
+            {"l1Conflict", stats.classified ? stats.l1Classes.conflict : 0},
+            {"l2Compulsory", stats.classified ? stats.l2Classes.compulsory : 0},
+            {"l2Capacity", stats.classified ? stats.l2Classes.capacity : 0},
+            {"l2Conflict", stats.classified ? stats.l2Classes.conflict : 0}};
+    return vector<Counter>(fields, fields + sizeof(fields) / sizeof(fields[0]));
+}
+
+/**
+ * @return the derived statistics and the runtime, the runtime NaN when it is left out. a sampled run gives the
+ * estimates of the sampler and their confidence intervals, NaN for a run that is not sampled
+ */
+static vector<Rate> rateFields(const CacheStats& stats, const RunSummary& run){
+    double seconds = run.seconds >= 0 ? run.seconds : __builtin_nan("");
+    SampleEstimate sample;
+    if (run.sampler != NULL)
+        sample = run.sampler->estimate();
+    else {
+        sample.l1Miss = stats.l1accesses ? stats.getL1MissRate() : 0.0;
+        sample.l2Miss = stats.l1Misses ? stats.getL2MissRate() : 0.0;
+        sample.accTime = stats.l1accesses ? stats.accTimeAVG() : 0.0;
+        sample.l1Half = sample.l2Half = sample.accTimeHalf = __builtin_nan("");
+    }
+    Rate fields[] = {
+            {"l1MissRate", sample.l1Miss},
+            {"l2MissRate", sample.l2Miss},
+            {"accTimeAvg", sample.accTime},
+            {"seconds", seconds},
+            {"accessesPerSecond", seconds > 0 ? stats.l1accesses / seconds : seconds},
+            {"l1MissRateLow", sample.l1Miss - sample.l1Half}, {"l1MissRateHigh", sample.l1Miss + sample.l1Half},
+            {"l2MissRateLow", sample.l2Miss - sample.l2Half}, {"l2MissRateHigh", sample.l2Miss + sample.l2Half},
+            {"accTimeAvgLow", sample.accTime - sample.accTimeHalf},
+            {"accTimeAvgHigh", sample.accTime + sample.accTimeHalf}};
+    return vector<Rate>(fields, fields + sizeof(fields) / sizeof(fields[0]));
+}
+
+/**
+ * prints a rate with the 17 significant digits that read back as the same double, or the placeholder of a missing
+ * value when it is NaN
+ */
+static void printRate(FILE* out, double value, const char* missing){
+    if (value != value)
+        fprintf(out, "%s", missing);
+    else
+        fprintf(out, "%.17g", value);
+}
+
+/**
+ * prints a string as a JSON string literal
+ */
+static void printJsonString(FILE* out, const char* text){
+    fputc('"', out);
+    for (; *text != '\0'; text++){
+        unsigned char c = *text;
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+/**
+ * prints a string as a CSV field, quoted when it holds a separator, a quote or a line break
+ */
+static void printCsvString(FILE* out, const char* text){
+    if (strpbrk(text, ",\"\r\n") == NULL){
+        fprintf(out, "%s", text);
+        return;
+    }
+    fputc('"', out);
+    for (; *text != '\0'; text++){
+        if (*text == '"')
+            fputc('"', out);
+        fputc(*text, out);
+    }
+    fputc('"', out);
+}
+
+/**
+ * prints the members of a JSON object of counters
+ */
+static void printJsonCounters(FILE* out, const char* object, const vector<Counter>& fields){
+    fprintf(out, "  \"%s\": {", object);
+    for (unsigned int i = 0; i < fields.size(); i++)
+        fprintf(out, "%s\"%s\": %llu", i ? ", " : "", fields[i].name, fields[i].value);
+    fprintf(out, "},\n");
+}
+
+/**
+ * writes the record of a run
+ * @param out stream to write to
+ * @param format JSON_RESULTS, CSV_RESULTS or BINARY_RESULTS
+ * @param header true to start a CSV with the line of column names
+ * @param config configuration of the run
+ * @param stats counters at the end of the run
+ * @param run trace, records and runtime of the run
+ * @return false if the record could not be written
+ */
+bool writeResults(FILE* out, RESULT_FORMAT format, bool header, const CacheConfig& config, const CacheStats& stats,
+                  const RunSummary& run){
+    vector<Counter> configs = configFields(config, run), counters = counterFields(stats, run);
+    vector<Rate> rates = rateFields(stats, run);
+    if (format == JSON_RESULTS){
+        fprintf(out, "{\n  \"trace\": ");
+        printJsonString(out, run.trace);
+        fprintf(out, ",\n  \"records\": %llu,\n", run.records);
+        printJsonCounters(out, "config", configs);
+        printJsonCounters(out, "counters", counters);
+        fprintf(out, "  \"rates\": {");
+        for (unsigned int i = 0; i < rates.size(); i++){
+            fprintf(out, "%s\"%s\": ", i ? ", " : "", rates[i].name);
+            printRate(out, rates[i].value, "null");
+        }
+        fprintf(out, "}\n}\n");
+    } else if (format == CSV_RESULTS){
+        if (header){
+            fprintf(out, "trace,records");
+            for (unsigned int i = 0; i < configs.size(); i++)
+                fprintf(out, ",%s", configs[i].name);
+            for (unsigned int i = 0; i < counters.size(); i++)
+                fprintf(out, ",%s", counters[i].name);
+            for (unsigned int i = 0; i < rates.size(); i++)
+                fprintf(out, ",%s", rates[i].name);
+            fprintf(out, "\n");
+        }
+        printCsvString(out, run.trace);
+        fprintf(out, ",%llu", run.records);
+        for (unsigned int i = 0; i < configs.size(); i++)
+            fprintf(out, ",%llu", configs[i].value);
+        for (unsigned int i = 0; i < counters.size(); i++)
+            fprintf(out, ",%llu", counters[i].value);
+        for (unsigned int i = 0; i < rates.size(); i++){
+            fprintf(out, ",");
+            printRate(out, rates[i].value, "");
+        }
+        fprintf(out, "\n");
+    } else if (format == BINARY_RESULTS){
+        uint32_t shape[5] = {RESULTS_VERSION, (uint32_t)configs.size(), (uint32_t)counters.size(),
+                             (uint32_t)rates.size(), (uint32_t)strlen(run.trace)};
+        fwrite(RESULTS_MAGIC, sizeof(RESULTS_MAGIC), 1, out);
+        fwrite(shape, sizeof(shape), 1, out);
+        for (unsigned int i = 0; i < configs.size(); i++){
+            uint64_t value = configs[i].value;
+            fwrite(&value, sizeof(value), 1, out);
+        }
+        for (unsigned int i = 0; i < counters.size(); i++){
+            uint64_t value = counters[i].value;
+            fwrite(&value, sizeof(value), 1, out);
+        }
+        for (unsigned int i = 0; i < rates.size(); i++)
+            fwrite(&rates[i].value, sizeof(double), 1, out);
+        fwrite(run.trace, 1, shape[4], out);
+    } else
+        return false;
+    return !ferror(out);
+}
@@ -0,0 +1,30 @@
+//
+// Machine-readable results of a run: the configuration, every counter and the runtime as JSON, CSV or binary.
+//
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stdio.h>
+#include "cacheSimulator.h"
+#include "sampling.h"
+
+using namespace std;
+
+enum RESULT_FORMAT {TEXT_RESULTS, JSON_RESULTS, CSV_RESULTS, BINARY_RESULTS};
+
+/**
+ * what a run measured besides the counters of the cache
+ */
+struct RunSummary{
+    const char* trace;          // trace file of the run, the first one when traces are co-scheduled
+    unsigned long long records; // trace records simulated
+    double seconds;             // wall clock time of the simulation loop, negative to leave it out
+    const Sampler* sampler;     // sampler of a sampled run, whose estimates replace the counters it scales
+    RunSummary() : trace(""), records(0), seconds(-1), sampler(NULL){}
+};
+
+bool writeResults(FILE* out, RESULT_FORMAT format, bool header, const CacheConfig& config, const CacheStats& stats,
+                  const RunSummary& run);
+
+#endif // RESULTS_H
@@ -0,0 +1,154 @@
+//
+// Reuse distance histograms and working-set size over time, estimated in one pass with sublinear memory.
+//
+
+#include <math.h>
+#include "cache.h"
+#include "reuseProfiler.h"
+
+static const unsigned int HLL_PRECISION = 12;  // 4096 registers, about 1.6% standard error
+
+/**
+ * @return a well mixed hash of a block number (murmur3 finalizer)
+ */
+static uint64_t hashBlock(uint64_t block){
+    block ^= block >> 33;
+    block *= 0xff51afd7ed558ccdull;
+    block ^= block >> 33;
+    block *= 0xc4ceb9fe1a85ec53ull;
+    block ^= block >> 33;
+    return block;
+}
+
+/**
+ * @param hash hash of a key, the first bits choose the register and the rest give the rank
+ */
+void HyperLogLog::add(uint64_t hash){
+    uint64_t rest = hash << precision;
+    uint8_t rank = rest == 0 ? 64 - precision + 1 : __builtin_clzll(rest) + 1;
+    uint8_t& reg = registers[hash >> (64 - precision)];
+    if (rank > reg)
+        reg = rank;
+}
+
+/**
+ * @return the estimated number of distinct keys, using linear counting while many registers are still empty
+ */
+double HyperLogLog::estimate() const{
+    double m = registers.size();
+    double sum = 0;
+    unsigned int zeros = 0;
+    for (unsigned int i = 0; i < registers.size(); i++){
+        sum += ldexp(1.0, -registers[i]);
+        zeros += registers[i] == 0;
+    }
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * log(m / zeros);
+    return estimate;
+}
+
+void HyperLogLog::clear(){
+    registers.assign(registers.size(), 0);
+}
+
+
+/**
+ * @param bSize log2 of the block size
+ * @param sampleBits follow one out of every 2^sampleBits blocks (0 follows all of them)
+ * @param window accesses per working-set window (0 only counts the whole trace)
+ */
+ReuseProfiler::ReuseProfiler(unsigned int bSize, unsigned int sampleBits, unsigned long long window) :
+        bSize(bSize),
+        sampleBits(sampleBits),
+        window(window),
+        histogram(65, 0),
+        coldMisses(0),
+        sampled(0),
+        accesses(0),
+        windowBlocks(HLL_PRECISION),
+        totalBlocks(HLL_PRECISION){}
+
+/**
+ * renumbers the sampled timestamps so that only the latest access of every sampled block is kept
+ */
+void ReuseProfiler::compact(){
+    FenwickTree compacted;
+    vector<uint64_t> latest;
+    latest.reserve(lastAccess.size());
+    for (unsigned int time = 1; time <= owner.size(); time++){
+        uint32_t& last = lastAccess[owner[time - 1]];
+        if (last != time)
+            continue;
+        latest.push_back(owner[time - 1]);
+        compacted.append(1);
+        last = latest.size();
+    }
+    marks = compacted;
+    owner.swap(latest);
+}
+
+/**
+ * records an access
+ * @param address accessed address
+ */
+void ReuseProfiler::access(uint64_t address){
+    accesses++;
+    uint64_t block = getTag(address, 0, bSize) >> bSize;
+    uint64_t hash = hashBlock(block);
+    totalBlocks.add(hash);
+    if (window){
+        windowBlocks.add(hash);
+        if (accesses % window == 0){
+            workingSets.push_back(windowBlocks.estimate());
+            windowBlocks.clear();
+        }
+    }
+    // the low bits of the hash choose the sampled blocks, the high ones are used by HyperLogLog
+    if (sampleBits && (hash & ((1ull << sampleBits) - 1)) != 0)
+        return;
+    sampled++;
+    unordered_map<uint64_t, uint32_t>::iterator it = lastAccess.find(block);
+    if (it == lastAccess.end())
+        coldMisses++;
+    else {
+        unsigned long long distance = marks.prefix(marks.size()) - marks.prefix(it->second);
+        distance <<= sampleBits;
+        unsigned int bucket = 0;
+        while (distance > 0){
+            distance >>= 1;
+            bucket++;
+        }
+        histogram[bucket]++;
+        marks.add(it->second, -1);
+    }
+    marks.append(1);
+    owner.push_back(block);
+    lastAccess[block] = owner.size();
+    if (owner.size() >= 2 * lastAccess.size() + 64)
+        compact();
+}
+
+/**
+ * prints the reuse distance histogram and the working-set sizes, every count scaled back to the whole trace
+ * @param out stream to print to
+ */
+void ReuseProfiler::print(FILE* out) const{
+    double scale = ldexp(1.0, sampleBits);
+    fprintf(out, "Reuse accesses=%llu sampled=%llu cold=%.0f\n", accesses, sampled, coldMisses * scale);
+    unsigned int end = 0;      // past the last bucket with a reuse, none are printed when no sampled block was reused
+    for (unsigned int bucket = 0; bucket < histogram.size(); bucket++){
+        if (histogram[bucket])
+            end = bucket + 1;
+    }
+    for (unsigned int bucket = 0; bucket < end; bucket++){
+        unsigned long long low = bucket ? 1ull << (bucket - 1) : 0, high = 1ull << bucket;
+        fprintf(out, "Reuse distance=[%llu,%llu) count=%.0f\n", low, high, histogram[bucket] * scale);
+    }
+    for (unsigned int i = 0; i < workingSets.size(); i++)
+        fprintf(out, "WSS window=%u accesses=%llu blocks=%.0f\n", i, window, workingSets[i]);
+    if (window && accesses % window)
+        fprintf(out, "WSS window=%u accesses=%llu blocks=%.0f\n", (unsigned int)workingSets.size(), accesses % window,
+                windowBlocks.estimate());
+    fprintf(out, "WSS total blocks=%.0f\n", totalBlocks.estimate());
+}
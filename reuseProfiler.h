@@ -0,0 +1,59 @@
+//
+// Reuse distance histograms and working-set size over time, estimated in one pass with sublinear memory.
+//
+
+#ifndef REUSE_PROFILER_H
+#define REUSE_PROFILER_H
+
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include <unordered_map>
+#include "stackDistance.h"
+
+using namespace std;
+
+/**
+ * estimates the number of distinct keys added to it with a fixed number of registers (HyperLogLog)
+ */
+class HyperLogLog{
+    vector<uint8_t> registers;
+    const unsigned int precision;
+public:
+    explicit HyperLogLog(unsigned int precision) : registers(1u << precision, 0), precision(precision){}
+    void add(uint64_t hash);
+    double estimate() const;
+    void clear();
+};
+
+/**
+ * profiles the block reuse of a trace.
+ * the reuse distance of an access is the number of distinct blocks touched since the previous access to its block.
+ * only the blocks whose hash falls in a 2^-sampleBits fraction are followed (spatial sampling), so the tree and
+ * the map grow with the sampled blocks only, and distances and counts are scaled back by 2^sampleBits.
+ * following every block (sampleBits 0) gives exact distances but keeps a timestamp per distinct block of the trace.
+ * the working set (distinct blocks) of every window of accesses and of the whole trace is counted with HyperLogLog.
+ */
+class ReuseProfiler{
+    const unsigned int bSize;
+    const unsigned int sampleBits;
+    const unsigned long long window;
+    FenwickTree marks;                          // latest access of every sampled block, by sampled timestamp
+    vector<uint64_t> owner;                     // block accessed at every sampled timestamp
+    unordered_map<uint64_t, uint32_t> lastAccess;
+    vector<unsigned long long> histogram;       // log2 buckets of the sampled distances
+    unsigned long long coldMisses;
+    unsigned long long sampled;
+    unsigned long long accesses;
+    HyperLogLog windowBlocks;
+    HyperLogLog totalBlocks;
+    vector<double> workingSets;                 // estimated distinct blocks of every finished window
+
+    void compact();
+public:
+    ReuseProfiler(unsigned int bSize, unsigned int sampleBits, unsigned long long window);
+    void access(uint64_t address);
+    void print(FILE* out) const;
+};
+
+#endif // REUSE_PROFILER_H
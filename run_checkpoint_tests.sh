@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Splits the traces of the test suite in two and simulates the second half from a checkpoint of the first one:
+# the split run has to count what the whole trace counts and print the miss rates the test expects.
+# Usage: run_checkpoint_tests.sh [path to cacheSim]
+
+sim=${1:-./cacheSim}
+passedAll=true
+checked=0
+workDir=$(mktemp -d)
+trap 'rm -rf "${workDir}"' EXIT
+
+for filename in tests/test*.command; do
+    test_num=${filename%.command}
+    trace=$(cut -d' ' -f2 ${filename})
+    options=$(cut -d' ' -f3- ${filename})
+    # compressed and binary traces cannot be split by lines
+    grep -Iq . "${trace}" || continue
+    # no counters for options a checkpoint does not hold and for traces that end in an error
+    whole=$(${sim} "${trace}" ${options} --save-state "${workDir}/state" --format json 2>&1 | grep '"counters"')
+    [ -n "$whole" ] || continue
+    lines=$(wc -l < "${trace}")
+    head -n $((lines / 2)) "${trace}" > "${workDir}/first"
+    tail -n +$((lines / 2 + 1)) "${trace}" > "${workDir}/second"
+    ${sim} "${workDir}/first" ${options} --save-state "${workDir}/state" > /dev/null
+    split=$(${sim} "${workDir}/second" ${options} --load-state "${workDir}/state" --format json | grep '"counters"')
+    expected=${test_num}.OURS
+    [ -f "$expected" ] || expected=${test_num}.out
+    # progress reports and trace profiles only follow the records of the run
+    rates=$(${sim} "${workDir}/second" ${options} --load-state "${workDir}/state" | grep '^L1miss')
+    if [ "$split" != "$whole" ] || [ "$rates" != "$(grep '^L1miss' "$expected")" ]; then
+        echo The checkpoint check of ${test_num} didnt pass
+        passedAll=false
+    fi
+    checked=$((checked + 1))
+done
+
+if [[ "$passedAll" == "true" && $checked -gt 0 ]]; then
+    echo "Split runs match the whole traces on ${checked} tests"
+else
+    exit 1
+fi
@@ -4,28 +4,30 @@ echo Running tests...
 echo The test succeed if there are no diffs printed.
 echo
 
-for filename in tests/test*.command; do
-    test_num=`echo $filename | cut -d'.' -f1`
-     bash ${filename} > ${test_num}.YoursOut
-done
+start=$(date +%s%N)
 
-passedAll=true
-ok=true
-for filename in tests/test*.out; do
-    test_num=`echo $filename | cut -d'.' -f1`
-    diff_result=$(diff ${test_num}.OURS ${test_num}.YoursOut)
-    if [ "$diff_result" != "" ]; then
-        echo The test ${test_num} didnt pass
-        passedAll=false
-    else 
+# Runs one test and compares its output with the expected one without writing it to disk
+check() {
+    test_num=$1
+    expected=${test_num}.OURS
+    [ -f "$expected" ] || expected=${test_num}.out
+    if bash ${test_num}.command | cmp -s - "$expected"; then
         echo The test ${test_num} PASSED!
+    else
+        echo The test ${test_num} didnt pass
     fi
-done
+}
+export -f check
+
+results=$(ls tests/test*.command | sed 's/\.command$//' | sort -V |
+          xargs -P "$(nproc)" -I{} bash -c 'check {}' | sort -V -k3)
+echo "$results"
 
 echo
-echo Ran all tests.
+elapsed=$((($(date +%s%N) - start) / 1000000))
+echo Ran all tests in $((elapsed / 1000)).$(printf %03d $((elapsed % 1000))) seconds.
 
-if [[ "$passedAll" == "$ok" ]]; then
+if ! echo "$results" | grep -q "didnt pass"; then
     echo 'PASSED ALL ~~~ ya malik!'
 else 
 	echo 'Try again'
@@ -0,0 +1,24 @@
+#!/bin/bash
+
+# Cross checks the stack distance profiler against a CacheHierarchy simulation of every
+# cache geometry it profiles, on every trace of the test suite.
+# Usage: run_mrc_tests.sh [path to cacheSim]
+
+sim=${1:-./cacheSim}
+passedAll=true
+
+for filename in tests/test*.command; do
+    command=$(sed "s#^./cacheSim#${sim}#" ${filename})
+    # the last 13 bytes, since a binary dump before it may leave no line break
+    result=$(${command} --mrc-verify 1 | tail -c 13)
+    if [ "$result" != "MRC verified" ]; then
+        echo The stack distance check of ${filename} didnt pass
+        passedAll=false
+    fi
+done
+
+if [[ "$passedAll" == "true" ]]; then
+    echo 'Stack distances match CacheHierarchy on all tests'
+else
+    exit 1
+fi
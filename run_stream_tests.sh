@@ -0,0 +1,73 @@
+#!/bin/bash
+
+# Streams traces into the simulator while they are produced: through the standard input, through a named pipe,
+# and with a producer that keeps its end open after the simulator has given up on the trace.
+# Usage: run_stream_tests.sh [path to cacheSim]
+
+sim=${1:-./cacheSim}
+passedAll=true
+workDir=$(mktemp -d)
+fifo=${workDir}/trace
+trap 'rm -rf "${workDir}"' EXIT
+mkfifo "${fifo}"
+
+# Runs the simulator with a time limit, a run that outlives it is stuck on the pipe
+# sets output to what it printed and hung to true when it had to be killed
+run() {
+    output=$(timeout 10 ${sim} "$@" 2>&1)
+    if [ $? -eq 124 ]; then hung=true; else hung=false; fi
+}
+
+# Compares the last run with what it should print
+# $1 name of the check, $2 expected output
+expect() {
+    if [ "$hung" == "true" ]; then
+        echo The stream check $1 didnt pass: the simulator did not exit
+        passedAll=false
+    elif [ "$output" != "$2" ]; then
+        echo The stream check $1 didnt pass: expected \"$2\", got \"$output\"
+        passedAll=false
+    fi
+}
+
+# the traces of the suite give the same report streamed as read from disk
+for test_num in tests/test1 tests/test12; do
+    options=$(cut -d' ' -f3- ${test_num}.command)
+    expected=${test_num}.OURS
+    [ -f "$expected" ] || expected=${test_num}.out
+    run - ${options} < ${test_num}.in
+    expect "stdin ${test_num}" "$(cat "$expected")"
+    cat ${test_num}.in > "${fifo}" &
+    run "${fifo}" ${options}
+    expect "fifo ${test_num}" "$(cat "$expected")"
+    wait
+done
+
+# a malformed record ends the run while the producer still holds its end open
+options=$(cut -d' ' -f3- tests/test1.command)
+{ head -3 tests/test1.in; echo; exec sleep 30; } > "${fifo}" &
+producer=$!
+run "${fifo}" ${options}
+expect "fifo format error" "Command Format error"
+kill ${producer} 2>/dev/null
+
+run - ${options} < <(head -3 tests/test1.in; echo; exec sleep 30)
+producer=$!
+expect "stdin format error" "Command Format error"
+kill ${producer} 2>/dev/null
+
+# a compressed trace cut short is a read error, not a shorter trace
+run - ${options} < <(head -c 60 tests/test991.gz)
+expect "truncated gzip" "Error reading the trace"
+run - ${options} < tests/test991.gz
+expect "gzip" "$(cat tests/test991.OURS)"
+
+# invalid options are reported before the pipe is opened, without waiting for a producer
+run "${fifo}" ${options} --bsize 9
+expect "fifo invalid option" "L1 is smaller than one set: --l1-size must be at least --bsize + --l1-assoc"
+
+if [[ "$passedAll" == "true" ]]; then
+    echo 'Streamed traces match the traces on disk'
+else
+    exit 1
+fi
@@ -0,0 +1,159 @@
+//
+// Set sampling and time sampling of a trace, with confidence intervals on the estimated statistics.
+//
+
+#include <math.h>
+#include "cache.h"
+#include "sampling.h"
+
+/**
+ * @param setSample simulate one out of every setSample sets (1 simulates all of them)
+ * @param period length of a time sampling period in records (0 disables time sampling)
+ * @param window number of measured records at the end of every period
+ * @param warmup number of simulated but not measured records before every window
+ * @param numOfSetBits set bits of the hierarchy used for set sampling
+ * @param bSize log2 of the block size
+ */
+Sampler::Sampler(unsigned int setSample, unsigned int period, unsigned int window, unsigned int warmup,
+                 unsigned int numOfSetBits, unsigned int bSize) :
+        setSample(setSample ? setSample : 1),
+        period(period),
+        window(period && window > period ? period : window),
+        warmup(period && warmup > period - this->window ? period - this->window : warmup),
+        numOfSetBits(numOfSetBits),
+        bSize(bSize),
+        sampledSets(0),
+        records(0),
+        current(NULL){
+    for (uint32_t set = 0; set < (1u << numOfSetBits); set++){
+        if (isSampledSet(set))
+            sampledSets++;
+    }
+    if (!period)
+        units.resize(1u << numOfSetBits);
+}
+
+/**
+ * @param setIndex index of a set of the sampled hierarchy
+ * @return true if the set is simulated
+ */
+bool Sampler::isSampledSet(uint32_t setIndex) const{
+    // murmur3 finalizer, so strided set indices do not all land in the same residue
+    uint32_t hash = setIndex;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+    return hash % setSample == 0;
+}
+
+/**
+ * advances to the next trace record
+ * @param address address of the record
+ * @return whether the record should be skipped, simulated for warm-up or simulated and measured
+ */
+SAMPLE_PHASE Sampler::next(uint64_t address){
+    unsigned long long position = records++;
+    uint32_t setIndex = getSet(address, numOfSetBits, bSize) >> bSize;
+    if (!isSampledSet(setIndex))
+        return SKIP;
+    if (!period){
+        current = &units[setIndex];
+        return MEASURE;
+    }
+    unsigned long long offset = position % period;
+    if (offset < period - window - warmup)
+        return SKIP;
+    if (offset < period - window)
+        return WARMUP;
+    unsigned long long windowIndex = position / period;
+    if (units.size() <= windowIndex)
+        units.resize(windowIndex + 1);
+    current = &units[windowIndex];
+    return MEASURE;
+}
+
+/**
+ * adds the statistics of the last measured record to its sampling unit
+ */
+void Sampler::record(unsigned long long accesses, unsigned long long l1Misses, unsigned long long l2Misses,
+                     unsigned long long cycles){
+    current->accesses += accesses;
+    current->l1Misses += l1Misses;
+    current->l2Misses += l2Misses;
+    current->cycles += cycles;
+}
+
+/**
+ * computes a ratio estimator over the sampling units and the half width of its 95% confidence interval
+ * @param ratio the estimated ratio sum(y) / sum(x)
+ * @param halfWidth half width of the interval, NAN if there are less than two units
+ * @param y numerator field
+ * @param x denominator field
+ */
+void Sampler::ratioInterval(double& ratio, double& halfWidth, unsigned long long Unit::*y,
+                            unsigned long long Unit::*x) const{
+    double sumY = 0, sumX = 0;
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < units.size(); i++){
+        if (period && units[i].accesses == 0)
+            continue;   // a window that was never reached
+        if (!period && !isSampledSet(i))
+            continue;
+        sumY += units[i].*y;
+        sumX += units[i].*x;
+        n++;
+    }
+    ratio = sumX > 0 ? sumY / sumX : 0;
+    halfWidth = NAN;
+    if (n < 2 || sumX == 0)
+        return;
+    double squares = 0;
+    for (unsigned int i = 0; i < units.size(); i++){
+        if ((period && units[i].accesses == 0) || (!period && !isSampledSet(i)))
+            continue;
+        double residual = double(units[i].*y) - ratio * double(units[i].*x);
+        squares += residual * residual;
+    }
+    double meanX = sumX / n;
+    // finite population correction: the population is every set, or every window of the trace
+    double population = period ? double(records) / window : double(1u << numOfSetBits);
+    double correction = population > n ? 1 - n / population : 0;
+    halfWidth = 1.96 * sqrt(correction * squares / (n - 1) / n) / meanX;
+}
+
+/**
+ * @return the estimated statistics and their confidence intervals
+ */
+SampleEstimate Sampler::estimate() const{
+    SampleEstimate result;
+    ratioInterval(result.l1Miss, result.l1Half, &Unit::l1Misses, &Unit::accesses);
+    ratioInterval(result.l2Miss, result.l2Half, &Unit::l2Misses, &Unit::l1Misses);
+    ratioInterval(result.accTime, result.accTimeHalf, &Unit::cycles, &Unit::accesses);
+    result.measured = 0;
+    for (unsigned int i = 0; i < units.size(); i++)
+        result.measured += units[i].accesses;
+    result.records = records;
+    return result;
+}
+
+/**
+ * prints the estimated statistics, their confidence intervals and the counters scaled back to the whole trace
+ * @param out stream to print to
+ */
+void Sampler::print(FILE* out) const{
+    SampleEstimate sample = estimate();
+    fprintf(out, "L1miss=%.03f ", sample.l1Miss);
+    fprintf(out, "L2miss=%.03f ", sample.l2Miss);
+    fprintf(out, "AccTimeAvg=%.03f\n", sample.accTime);
+
+    fprintf(out, "L1miss CI95=[%.03f, %.03f] ", sample.l1Miss - sample.l1Half, sample.l1Miss + sample.l1Half);
+    fprintf(out, "L2miss CI95=[%.03f, %.03f] ", sample.l2Miss - sample.l2Half, sample.l2Miss + sample.l2Half);
+    fprintf(out, "AccTimeAvg CI95=[%.03f, %.03f]\n", sample.accTime - sample.accTimeHalf,
+            sample.accTime + sample.accTimeHalf);
+
+    double l1Misses = sample.l1Miss * sample.records;
+    fprintf(out, "Sampled %llu of %llu accesses, scaled l1accesses=%llu l1Misses=%.0f l2Misses=%.0f\n",
+            sample.measured, sample.records, sample.records, l1Misses, sample.l2Miss * l1Misses);
+}
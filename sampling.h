@@ -0,0 +1,85 @@
+//
+// Set sampling and time sampling of a trace, with confidence intervals on the estimated statistics.
+//
+
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+using namespace std;
+
+enum SAMPLE_PHASE {SKIP, WARMUP, MEASURE};
+
+/**
+ * the statistics of the whole trace estimated from the measured records, every half width of a 95% confidence
+ * interval is NAN when there are less than two sampling units
+ */
+struct SampleEstimate{
+    double l1Miss;
+    double l1Half;
+    double l2Miss;
+    double l2Half;
+    double accTime;
+    double accTimeHalf;
+    unsigned long long measured;    // accesses of the measured records
+    unsigned long long records;     // every record of the trace, simulated or not
+};
+
+/**
+ * decides which trace records are simulated and collects the statistics of the measured ones.
+ * set sampling simulates only the sets whose hashed index is selected, where the index is taken from the
+ * hierarchy with fewer set bits so every set of both hierarchies is either fully simulated or skipped.
+ * time sampling splits the trace into periods and simulates a warm-up part followed by a measured window at the
+ * end of every period. the measured sets (or windows when time sampling is on) are the sampling units.
+ */
+class Sampler{
+    struct Unit{
+        unsigned long long accesses;
+        unsigned long long l1Misses;
+        unsigned long long l2Misses;
+        unsigned long long cycles;
+        Unit() : accesses(0), l1Misses(0), l2Misses(0), cycles(0){}
+    };
+    const unsigned int setSample;
+    const unsigned int period;
+    const unsigned int window;
+    const unsigned int warmup;
+    const unsigned int numOfSetBits;
+    const unsigned int bSize;
+    unsigned int sampledSets;
+    unsigned long long records;
+    vector<Unit> units;
+    Unit* current;
+
+    void ratioInterval(double& ratio, double& halfWidth, unsigned long long Unit::*y,
+                       unsigned long long Unit::*x) const;
+public:
+    Sampler(unsigned int setSample, unsigned int period, unsigned int window, unsigned int warmup,
+            unsigned int numOfSetBits, unsigned int bSize);
+    bool isSampledSet(uint32_t setIndex) const;
+    unsigned int getSampledSets() const{
+        return sampledSets;
+    }
+    unsigned int getSetSample() const{
+        return setSample;
+    }
+    unsigned int getPeriod() const{
+        return period;
+    }
+    unsigned int getWindow() const{
+        return window;
+    }
+    unsigned int getWarmup() const{
+        return warmup;
+    }
+    SAMPLE_PHASE next(uint64_t address);
+    void record(unsigned long long accesses, unsigned long long l1Misses, unsigned long long l2Misses,
+                unsigned long long cycles);
+    SampleEstimate estimate() const;
+    void print(FILE* out) const;
+};
+
+#endif // SAMPLING_H
@@ -0,0 +1,29 @@
+//
+// Set index functions: low-order bit selection, XOR folding, prime modulo and skewed (a hash per way).
+//
+
+#include "setIndex.h"
+
+/**
+ * @param function index function
+ * @param setBits log2 of the number of sets
+ */
+SetIndex::SetIndex(INDEX_FUNCTION function, unsigned int setBits) : function(function),
+                                                                    setBits(setBits),
+                                                                    mask((1ull << setBits) - 1),
+                                                                    foldSteps(0),
+                                                                    prime(1),
+                                                                    reciprocal(0){
+    if (setBits == 0)
+        this->function = BIT_SELECT;    // a single set, every function gives 0
+    while (setBits && (uint64_t)setBits << foldSteps < 64)
+        foldSteps++;
+    for (uint64_t candidate = 1ull << setBits; candidate >= 2 && prime == 1; candidate--){
+        bool isPrime = true;
+        for (uint64_t divisor = 2; divisor * divisor <= candidate && isPrime; divisor++)
+            isPrime = candidate % divisor != 0;
+        if (isPrime)
+            prime = candidate;
+    }
+    reciprocal = ~(__uint128_t)0 / prime + 1;
+}
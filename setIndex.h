@@ -0,0 +1,60 @@
+//
+// Set index functions: low-order bit selection, XOR folding, prime modulo and skewed (a hash per way).
+//
+
+#ifndef SET_INDEX_H
+#define SET_INDEX_H
+
+#include <stdint.h>
+
+enum INDEX_FUNCTION {BIT_SELECT, XOR_FOLD, PRIME_MODULO, SKEWED};
+
+/**
+ * maps a block number to a set of a level. the constants of the function are computed once, so an index is a few
+ * shifts, xors and multiplies with no data dependent branches:
+ * - BIT_SELECT takes the low bits of the block number
+ * - XOR_FOLD xors every setBits wide chunk of the block number into the low bits
+ * - PRIME_MODULO divides by the largest prime below the number of sets, with a precomputed reciprocal
+ * - SKEWED xors the low bits with a different multiplicative hash of the tag in every way
+ * every function keeps the low bits recoverable from the index and the tag, so blocks are still told apart by
+ * their block number.
+ */
+class SetIndex{
+    INDEX_FUNCTION function;
+    unsigned int setBits;
+    uint64_t mask;
+    unsigned int foldSteps;         // log2 of the chunks folded by XOR_FOLD
+    uint64_t prime;
+    __uint128_t reciprocal;         // 2^128 / prime rounded up, for the modulo without a division
+public:
+    explicit SetIndex(INDEX_FUNCTION function = BIT_SELECT, unsigned int setBits = 0);
+    INDEX_FUNCTION getFunction() const{
+        return function;
+    }
+    /**
+     * @param block block number (address without the offset bits)
+     * @param way way of a skewed level, ignored by the other functions
+     * @return the set of the block
+     */
+    uint64_t of(uint64_t block, unsigned int way) const{
+        switch (function){
+            case XOR_FOLD: {
+                uint64_t folded = block;
+                for (unsigned int step = 0; step < foldSteps; step++)
+                    folded ^= folded >> (setBits << step);  // prefix xor, the low chunk ends as the xor of all
+                return folded & mask;
+            }
+            case PRIME_MODULO: {
+                __uint128_t fraction = reciprocal * block;
+                __uint128_t low = ((__uint128_t)(uint64_t)fraction * prime) >> 64;
+                return (uint64_t)((low + (__uint128_t)(uint64_t)(fraction >> 64) * prime) >> 64);
+            }
+            case SKEWED:
+                return (block ^ (((block >> setBits) * (0x9e3779b97f4a7c15ull + 2ull * way)) >> 32)) & mask;
+            default:
+                return block & mask;
+        }
+    }
+};
+
+#endif // SET_INDEX_H
@@ -0,0 +1,818 @@
+//
+// The simulator behind the cacheSim command line: option parsing, the simulation loop and the report.
+//
+
+#include <chrono>
+#include <limits>
+#include <string>
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cacheSimulator.h"
+#include "configFile.h"
+#include "stackDistance.h"
+#include "results.h"
+#include "reuseProfiler.h"
+#include "sampling.h"
+#include "traceScheduler.h"
+#include "simulator.h"
+
+using namespace std;
+
+/**
+ * the trace, the optional instruments and the options a run needs besides the cache itself
+ */
+struct Simulation {
+	TraceSource* file;
+	TraceScheduler* scheduler;      // co-scheduled traces interleaved into file, NULL for a single trace
+	FILE* out;
+	FILE* err;
+	StackDistanceProfiler* profiler;
+	ReuseProfiler* reuse;
+	Sampler* sampler;
+	vector<uint64_t> trace; // kept only for cross checking the profiler
+	bool keepTrace;
+	unsigned long long reportEvery; // records between progress lines, 0 for none
+	unsigned attributionTop;        // regions and PCs printed by the attribution
+	const char* loadState;
+	const char* saveState;
+	const char* heatmap;            // file for the per-set counters, "-" for the output, NULL for none
+	bool heatmapBinary;
+	const char* traceName;
+	RESULT_FORMAT format;           // TEXT_RESULTS prints the report, any other format writes a record
+	const char* results;            // file the record is appended to, NULL to print it in place of the report
+	bool runtime;                   // put the runtime in the record, which makes it differ from run to run
+};
+
+/**
+ * @param name name given to --format
+ * @param format set to the format of the name
+ * @return false if there is no such format
+ */
+static bool parseFormat(const string& name, unsigned& format) {
+	const char* names[] = {"text", "json", "csv", "binary"};
+	for (unsigned i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		if (name == names[i]) {
+			format = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// names of the values of the options that choose one of a few policies, in the order of their numbers
+static const char* const INDEX_NAMES[] = {"bit", "xor", "prime", "skew", NULL};
+static const char* const INSERTION_NAMES[] = {"lru", "bip", "dip", NULL};
+static const char* const SCHEDULE_NAMES[] = {"round-robin", "timestamp", "weighted", NULL};
+static const char* const MAPPING_NAMES[] = {"identity", "sequential", "scattered", NULL};
+static const char* const PAGE_POLICY_NAMES[] = {"open", "closed", NULL};
+
+/**
+ * reads the value of a numeric option
+ * @param text value given to the option
+ * @param value set to the number
+ * @return false if text is not a decimal number that fits in value
+ */
+template <typename T>
+static bool parseNumber(const char* text, T& value) {
+	char* end;
+	errno = 0;
+	unsigned long long number = strtoull(text, &end, 10);
+	if (!isdigit((unsigned char)text[0]) || *end != '\0' || errno == ERANGE ||
+		number > (unsigned long long)numeric_limits<T>::max())
+		return false;
+	value = T(number);
+	return true;
+}
+
+/**
+ * reads the value of an option that chooses one of a few policies
+ * @param text value given to the option, the name of a policy or its number
+ * @param names names of the policies in the order of their numbers, NULL terminated
+ * @param value set to the number of the policy, a number past the names is left to the validation
+ * @return false if text is neither a name nor a number
+ */
+static bool parseName(const char* text, const char* const names[], unsigned& value) {
+	for (unsigned i = 0; names[i] != NULL; i++) {
+		if (strcmp(text, names[i]) == 0) {
+			value = i;
+			return true;
+		}
+	}
+	return parseNumber(text, value);
+}
+
+/**
+ * @param weights weights given to --weights
+ * @param traces number of co-scheduled traces
+ * @return true if every trace has a positive weight
+ */
+static bool validWeights(const vector<unsigned int>& weights, unsigned int traces) {
+	if (weights.size() != traces)
+		return false;
+	for (unsigned int i = 0; i < weights.size(); i++) {
+		if (weights[i] == 0)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @param text partitionings separated by ',', each a mask per trace separated by ':', such as "0x3:0xc,0x1:0xe"
+ * @param masks filled with the masks of every partitioning
+ * @return false if text is not a list of masks
+ */
+static bool parseWayMasks(const char* text, vector<vector<uint64_t> >& masks) {
+	masks.assign(1, vector<uint64_t>());
+	while (true) {
+		char* end;
+		masks.back().push_back(strtoull(text, &end, 0));
+		if (end == text)
+			return false;
+		if (*end == '\0')
+			return true;
+		if (*end == ',')
+			masks.push_back(vector<uint64_t>());
+		else if (*end != ':')
+			return false;
+		text = end + 1;
+	}
+}
+
+/**
+ * @param masks L2 way masks of every partitioning
+ * @param traces number of co-scheduled traces
+ * @param ways log2 of the L2 ways
+ * @return true if every partitioning gives every trace some of the ways and nothing else
+ */
+static bool validWayMasks(const vector<vector<uint64_t> >& masks, unsigned int traces, unsigned int ways) {
+	if (ways > 6)
+		return false;
+	uint64_t allWays = ways == 6 ? ~0ull : (1ull << (1u << ways)) - 1;
+	for (unsigned int i = 0; i < masks.size(); i++) {
+		if (masks[i].size() != traces)
+			return false;
+		for (unsigned int j = 0; j < traces; j++) {
+			if (masks[i][j] == 0 || (masks[i][j] & ~allWays) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * checks the geometry of both levels and of the TLBs as it is loaded, so that no set can hold more blocks than its
+ * ways and every set key fits in an int
+ * @return what is wrong with the geometry, NULL if it can be simulated
+ */
+static const char* geometryError(unsigned BSize, unsigned L1Size, unsigned L1Assoc, unsigned L2Size,
+								 unsigned L2Assoc, const TlbConfig& Tlb) {
+	if (L1Size >= 32 || L2Size >= 32)
+		return "--l1-size and --l2-size are log2 of bytes and must be below 32";
+	// a TLB level has blocks of one page number, its set keys are the set numbers themselves
+	if (Tlb.l1Size >= 31 || Tlb.l2Size >= 31)
+		return "--tlb1-size and --tlb2-size are log2 of entries and must be below 31";
+	if (Tlb.l1Assoc > Tlb.l1Size || Tlb.l2Assoc > Tlb.l2Size)
+		return "a TLB cannot have more ways than entries: --tlb1-assoc and --tlb2-assoc must be at most their size";
+	if (BSize + L1Assoc > L1Size)
+		return "L1 is smaller than one set: --l1-size must be at least --bsize + --l1-assoc";
+	if (BSize + L2Assoc > L2Size)
+		return "L2 is smaller than one set: --l2-size must be at least --bsize + --l2-assoc";
+	return NULL;
+}
+
+/**
+ * prints the report of a finished run
+ * @param cache simulated cache
+ * @param sim the simulation
+ * @param stats counters at the end of the run
+ */
+static void printReport(const CacheSimulator& cache, const Simulation& sim, const CacheStats& stats) {
+	if (sim.sampler != NULL) {
+		sim.sampler->print(sim.out);
+	} else {
+		double L1MissRate = stats.getL1MissRate();
+		double L2MissRate = stats.getL2MissRate();
+		double avgAccTime = stats.accTimeAVG();
+
+		fprintf(sim.out, "L1miss=%.03f ", L1MissRate);
+		fprintf(sim.out, "L2miss=%.03f ", L2MissRate);
+		fprintf(sim.out, "AccTimeAvg=%.03f\n", avgAccTime);
+	}
+	for (unsigned int i = 0; sim.scheduler != NULL && i < cache.getConfig().traces; i++) {
+		CacheStats trace = cache.getTraceStats(i);
+		fprintf(sim.out, "Trace %u accesses=%llu L1miss=%.03f L2miss=%.03f AccTimeAvg=%.03f\n", i, trace.l1accesses,
+				trace.getL1MissRate(), trace.getL2MissRate(), trace.accTimeAVG());
+	}
+	if (cache.getConfig().timing.enabled) {
+		fprintf(sim.out, "Timing bankConflicts=%llu bankWait=%llu mshrWait=%llu l1Merges=%llu l2Merges=%llu\n",
+				stats.bankConflicts, stats.bankWaitCycles, stats.mshrWaitCycles, stats.l1MshrMerges,
+				stats.l2MshrMerges);
+	}
+	if (cache.getConfig().l1WriteThrough) {
+		fprintf(sim.out, "WriteBuffer writes=%llu coalescing=%.03f occupancy=%.03f max=%u stall=%llu\n",
+				stats.bufferedWrites,
+				stats.bufferedWrites ? double(stats.coalescedWrites) / double(stats.bufferedWrites) : 0.0,
+				stats.bufferedWrites ? double(stats.bufferOccupancy) / double(stats.bufferedWrites) : 0.0,
+				stats.maxBufferOccupancy, stats.bufferStallCycles);
+	}
+	if (cache.getConfig().sectors) {
+		fprintf(sim.out, "Traffic fetched=%llu written=%llu saved=%llu\n", stats.fetchedBytes, stats.writtenBytes,
+				stats.savedBytes);
+	}
+	if (cache.getConfig().dram.enabled) {
+		fprintf(sim.out, "DRAM reads=%llu writes=%llu rowHits=%llu rowEmpty=%llu rowConflicts=%llu\n",
+				stats.dramReads, stats.dramWrites, stats.rowHits, stats.rowEmpty, stats.rowConflicts);
+	}
+	if (cache.getConfig().l2Insertion != LRU_INSERTION || cache.getConfig().l2Bypass) {
+		fprintf(sim.out, "Insertion psel=%u lruLeaderMisses=%llu bipLeaderMisses=%llu lruInserts=%llu bypassed=%llu\n",
+				stats.psel, stats.lruLeaderMisses, stats.bipLeaderMisses, stats.lruInsertions, stats.bypasses);
+	}
+	if (cache.getPartition() != NULL)
+		cache.getPartition()->print(sim.out);
+	if (stats.tlbAccesses) {
+		fprintf(sim.out, "TLB accesses=%llu L1miss=%.03f L2miss=%.03f\n", stats.tlbAccesses,
+				double(stats.tlbL1Misses) / double(stats.tlbAccesses),
+				stats.tlbL1Misses ? double(stats.tlbL2Misses) / double(stats.tlbL1Misses) : 0.0);
+	}
+
+	if (stats.classified) {
+		fprintf(sim.out, "L1 compulsory=%llu capacity=%llu conflict=%llu\n", stats.l1Classes.compulsory,
+				stats.l1Classes.capacity, stats.l1Classes.conflict);
+		fprintf(sim.out, "L2 compulsory=%llu capacity=%llu conflict=%llu\n", stats.l2Classes.compulsory,
+				stats.l2Classes.capacity, stats.l2Classes.conflict);
+	}
+	if (cache.getAttribution() != NULL) {
+		fprintf(sim.out, "Writebacks L1=%llu L2=%llu\n", stats.l1Writebacks, stats.l2Writebacks);
+		cache.getAttribution()->print(sim.out, sim.attributionTop);
+	}
+}
+
+/**
+ * writes the machine-readable record of a finished run, appended to the results file or printed
+ * @param cache simulated cache
+ * @param sim the simulation
+ * @param stats counters at the end of the run
+ * @param run trace, records and runtime of the run
+ * @return false if the record could not be written
+ */
+static bool writeRecord(const CacheSimulator& cache, const Simulation& sim, const CacheStats& stats,
+						const RunSummary& run) {
+	if (sim.results == NULL)
+		return writeResults(sim.out, sim.format, true, cache.getConfig(), stats, run);
+	FILE* file = fopen(sim.results, sim.format == BINARY_RESULTS ? "ab" : "a");
+	if (file == NULL)
+		return false;
+	// a CSV file gets its column names once, before its first row
+	bool empty = fseek(file, 0, SEEK_END) == 0 && ftell(file) == 0;
+	bool ok = writeResults(file, sim.format, empty, cache.getConfig(), stats, run);
+	return fclose(file) == 0 && ok;
+}
+
+/**
+ * simulates the trace and prints the results
+ * @param cache cache to simulate
+ * @param sim the running simulation
+ * @return false if the run failed
+ */
+static bool simulate(CacheSimulator& cache, Simulation& sim) {
+	if (sim.loadState != NULL && !cache.loadState(sim.loadState)) {
+		fprintf(sim.err, "Could not load a matching cache state from %s\n", sim.loadState);
+		return false;
+	}
+	StackDistanceProfiler* profiler = sim.profiler;
+	Sampler* sampler = sim.sampler;
+	TraceRecord record;
+	TRACE_STATUS status;
+	unsigned long long records = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	while ((status = sim.file->next(record)) == TRACE_RECORD) {
+		uint64_t num = record.address;
+		if (profiler != NULL)
+			profiler->access(num);
+		if (sim.reuse != NULL)
+			sim.reuse->access(num);
+		if (sim.keepTrace)
+			sim.trace.push_back(num);
+		if (sim.scheduler != NULL) {
+			cache.feed(record, sim.scheduler->current());
+		} else if (sampler == NULL) {
+			cache.feed(record);
+		} else {
+			SAMPLE_PHASE phase = sampler->next(num);
+			CacheStats before = cache.getStats();
+			if (phase != SKIP)
+				cache.feed(record);
+			if (phase == MEASURE) {
+				CacheStats after = cache.getStats();
+				sampler->record(after.l1accesses - before.l1accesses, after.l1Misses - before.l1Misses,
+								after.l2Misses - before.l2Misses, after.totalCycles - before.totalCycles);
+			}
+		}
+		records++;
+		if (sim.reportEvery && records % sim.reportEvery == 0) {
+			// a live trace may never end, so the counters so far are reported as it runs
+			CacheStats stats = cache.getStats();
+			fprintf(sim.out, "Progress records=%llu L1miss=%.03f L2miss=%.03f AccTimeAvg=%.03f\n", records,
+					stats.getL1MissRate(), stats.getL2MissRate(), stats.accTimeAVG());
+			fflush(sim.out);
+		}
+	}
+	if (status == TRACE_FORMAT_ERROR) {
+		// Operation appears in an Invalid format
+		fprintf(sim.out, "Command Format error\n");
+		return false;
+	}
+	if (sim.file->failed()) {
+		fprintf(sim.err, "Error reading the trace\n");
+		return false;
+	}
+	RunSummary run;
+	run.trace = sim.traceName;
+	run.records = records;
+	run.sampler = sim.sampler;
+	if (sim.runtime)
+		run.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	CacheStats stats = cache.getStats();
+	if (stats.tlbOverflowPages) {
+		// the pages past physical memory got frames of their own, a smaller memory would have to swap them
+		fprintf(sim.err, "Physical memory ran out: %llu pages did not fit in --phys-bits %u\n", stats.tlbOverflowPages,
+				cache.getConfig().tlb.physBits);
+		return false;
+	}
+	if (sim.format == TEXT_RESULTS || sim.results != NULL)
+		printReport(cache, sim, stats);
+	if (sim.saveState != NULL && !cache.saveState(sim.saveState))
+		fprintf(sim.err, "Could not save the cache state to %s\n", sim.saveState);
+	// "-" appends the heatmap to the report
+	if (sim.heatmap != NULL && !(string(sim.heatmap) == "-" ? cache.dumpHeatmap(sim.out, sim.heatmapBinary) :
+								 cache.dumpHeatmap(sim.heatmap, sim.heatmapBinary)))
+		fprintf(sim.err, "Could not write the heatmap to %s\n", sim.heatmap);
+	if (sim.format != TEXT_RESULTS && !writeRecord(cache, sim, stats, run))
+		fprintf(sim.err, "Could not write the results to %s\n", sim.results != NULL ? sim.results : "the output");
+	return true;
+}
+
+/**
+ * runs the simulator on a command line of the form "cacheSim <trace> --<option> <value> ...". "--preset <name>"
+ * and "--config <file>" give options too, which the command line overrides
+ * @param argc number of arguments
+ * @param argv arguments, argv[1] is the trace file, a named pipe, a UNIX socket or "-" for the standard input
+ * @param out stream the results are printed to
+ * @param err stream the errors are printed to
+ * @param trace already parsed trace to use instead of reading argv[1], NULL to read the file
+ * @return the exit code of the simulator
+ */
+int runCacheSim(int argc, char **argv, FILE* out, FILE* err, TraceSource* trace) {
+
+	if (argc < 2) {
+		fprintf(err, "Not enough arguments\n");
+		return 0;
+	}
+
+	// A preset, then a configuration file, then the command line, a later option overriding an earlier one
+	vector<string> optionText, origins;
+	string optionError;
+	if (!collectOptions(argc, argv, optionText, origins, optionError)) {
+		fprintf(err, "%s\n", optionError.c_str());
+		return 0;
+	}
+	const char* missing = missingOption(optionText);
+	if (missing != NULL) {
+		fprintf(err, "Missing option %s\n", missing);
+		return 0;
+	}
+	vector<char*> options;
+	for (unsigned int i = 0; i < optionText.size(); i++)
+		options.push_back(&optionText[i][0]);
+
+	// Get input arguments
+
+	unsigned MemCyc = 0, BSize = 0, L1Size = 0, L2Size = 0, L1Assoc = 0,
+			L2Assoc = 0, L1Cyc = 0, L2Cyc = 0, WrAlloc = 0;
+	unsigned ClassifyMisses = 0, Mrc = 0, MrcVerify = 0;
+	unsigned SetSample = 1, SamplePeriod = 0, SampleWindow = 0, SampleWarmup = 0;
+	unsigned AddrBits = 32, Sectors = 0, L1Index = BIT_SELECT, L2Index = BIT_SELECT;
+	unsigned L1WriteThrough = 0, WriteBufferDepth = 8, WriteBufferCyc = 0;
+	unsigned L2Insertion = LRU_INSERTION, L2Bypass = 0, BypassRegion = 12;
+	unsigned long long ReportEvery = 0;
+	unsigned Attribution = 0, RegionBits = 12, AttributionSlots = 4096;
+	// one block in 64 is followed by default, --reuse-sample-bits 0 follows every block with memory linear in them
+	unsigned ReuseProfile = 0, ReuseSampleBits = 6;
+	unsigned long long WssWindow = 0;
+	TlbConfig TlbOptions;
+	TimingConfig TimingOptions;
+	DramConfig DramOptions;
+	unsigned PageMap = TlbOptions.mapping, DramPage = DramOptions.policy;
+	char *SaveState = NULL, *LoadState = NULL, *Heatmap = NULL;
+	vector<const char*> Traces;     // co-scheduled with the trace of argv[1]
+	vector<unsigned int> Weights;
+	unsigned Schedule = ROUND_ROBIN;
+	vector<vector<uint64_t> > WayMasks;
+	bool WayMasksParsed = true;
+	unsigned long long RepartitionEvery = 0;
+	bool HeatmapBinary = false;
+	unsigned Format = TEXT_RESULTS, ResultsRuntime = 1;
+	bool FormatParsed = true;
+	char* Results = NULL;
+
+	for (unsigned int i = 0; i + 1 < options.size(); i += 2) {
+		string s(options[i]);
+		bool number = true;
+		const char* const* names = NULL;    // the names the option takes besides numbers
+		if (s == "--mem-cyc") {
+			number = parseNumber(options[i + 1], MemCyc);
+		} else if (s == "--bsize") {
+			number = parseNumber(options[i + 1], BSize);
+		} else if (s == "--l1-size") {
+			number = parseNumber(options[i + 1], L1Size);
+		} else if (s == "--l2-size") {
+			number = parseNumber(options[i + 1], L2Size);
+		} else if (s == "--l1-cyc") {
+			number = parseNumber(options[i + 1], L1Cyc);
+		} else if (s == "--l2-cyc") {
+			number = parseNumber(options[i + 1], L2Cyc);
+		} else if (s == "--l1-assoc") {
+			number = parseNumber(options[i + 1], L1Assoc);
+		} else if (s == "--l2-assoc") {
+			number = parseNumber(options[i + 1], L2Assoc);
+		} else if (s == "--wr-alloc") {
+			number = parseNumber(options[i + 1], WrAlloc);
+		} else if (s == "--classify-misses") {
+			number = parseNumber(options[i + 1], ClassifyMisses);
+		} else if (s == "--mrc") {
+			number = parseNumber(options[i + 1], Mrc);
+		} else if (s == "--mrc-verify") {
+			number = parseNumber(options[i + 1], MrcVerify);
+		} else if (s == "--set-sample") {
+			number = parseNumber(options[i + 1], SetSample);
+		} else if (s == "--sample-period") {
+			number = parseNumber(options[i + 1], SamplePeriod);
+		} else if (s == "--sample-window") {
+			number = parseNumber(options[i + 1], SampleWindow);
+		} else if (s == "--sample-warmup") {
+			number = parseNumber(options[i + 1], SampleWarmup);
+		} else if (s == "--save-state") {
+			SaveState = options[i + 1];
+		} else if (s == "--load-state") {
+			LoadState = options[i + 1];
+		} else if (s == "--heatmap" || s == "--heatmap-bin") {
+			Heatmap = options[i + 1];
+			HeatmapBinary = s == "--heatmap-bin";
+		} else if (s == "--format") {
+			FormatParsed = parseFormat(options[i + 1], Format);
+		} else if (s == "--results") {
+			Results = options[i + 1];
+		} else if (s == "--results-runtime") {
+			number = parseNumber(options[i + 1], ResultsRuntime);
+		} else if (s == "--l1-write-through") {
+			number = parseNumber(options[i + 1], L1WriteThrough);
+		} else if (s == "--write-buffer") {
+			number = parseNumber(options[i + 1], WriteBufferDepth);
+		} else if (s == "--write-buffer-cyc") {
+			number = parseNumber(options[i + 1], WriteBufferCyc);
+		} else if (s == "--l1-index") {
+			names = INDEX_NAMES;
+			number = parseName(options[i + 1], names, L1Index);
+		} else if (s == "--l2-index") {
+			names = INDEX_NAMES;
+			number = parseName(options[i + 1], names, L2Index);
+		} else if (s == "--l2-insertion") {
+			names = INSERTION_NAMES;
+			number = parseName(options[i + 1], names, L2Insertion);
+		} else if (s == "--l2-bypass") {
+			number = parseNumber(options[i + 1], L2Bypass);
+		} else if (s == "--bypass-region") {
+			number = parseNumber(options[i + 1], BypassRegion);
+		} else if (s == "--trace") {
+			Traces.push_back(options[i + 1]);
+		} else if (s == "--schedule") {
+			names = SCHEDULE_NAMES;
+			number = parseName(options[i + 1], names, Schedule);
+		} else if (s == "--weights") {
+			// one weight per trace, the trace of argv[1] first: "3:1"
+			char* weight = options[i + 1];
+			do
+				Weights.push_back(strtoul(weight, &weight, 10));
+			while (*weight++ == ':');
+			if (weight[-1] != '\0')
+				Weights.push_back(0);   // not a weight, rejected below
+		} else if (s == "--way-masks") {
+			WayMasksParsed = parseWayMasks(options[i + 1], WayMasks);
+		} else if (s == "--repartition-every") {
+			number = parseNumber(options[i + 1], RepartitionEvery);
+		} else if (s == "--sectors") {
+			number = parseNumber(options[i + 1], Sectors);
+		} else if (s == "--addr-bits") {
+			number = parseNumber(options[i + 1], AddrBits);
+		} else if (s == "--report-every") {
+			number = parseNumber(options[i + 1], ReportEvery);
+		} else if (s == "--attribution") {
+			number = parseNumber(options[i + 1], Attribution);
+		} else if (s == "--region-bits") {
+			number = parseNumber(options[i + 1], RegionBits);
+		} else if (s == "--attribution-slots") {
+			number = parseNumber(options[i + 1], AttributionSlots);
+		} else if (s == "--reuse-profile") {
+			number = parseNumber(options[i + 1], ReuseProfile);
+		} else if (s == "--reuse-sample-bits") {
+			number = parseNumber(options[i + 1], ReuseSampleBits);
+		} else if (s == "--wss-window") {
+			number = parseNumber(options[i + 1], WssWindow);
+		} else if (s == "--tlb") {
+			number = parseNumber(options[i + 1], TlbOptions.enabled);
+		} else if (s == "--page-bits") {
+			number = parseNumber(options[i + 1], TlbOptions.pageBits);
+		} else if (s == "--tlb1-size") {
+			number = parseNumber(options[i + 1], TlbOptions.l1Size);
+		} else if (s == "--tlb1-assoc") {
+			number = parseNumber(options[i + 1], TlbOptions.l1Assoc);
+		} else if (s == "--tlb1-cyc") {
+			number = parseNumber(options[i + 1], TlbOptions.l1Cyc);
+		} else if (s == "--tlb2-size") {
+			number = parseNumber(options[i + 1], TlbOptions.l2Size);
+		} else if (s == "--tlb2-assoc") {
+			number = parseNumber(options[i + 1], TlbOptions.l2Assoc);
+		} else if (s == "--tlb2-cyc") {
+			number = parseNumber(options[i + 1], TlbOptions.l2Cyc);
+		} else if (s == "--walk-cyc") {
+			number = parseNumber(options[i + 1], TlbOptions.walkCyc);
+		} else if (s == "--page-map") {
+			names = MAPPING_NAMES;
+			number = parseName(options[i + 1], names, PageMap);
+		} else if (s == "--phys-bits") {
+			number = parseNumber(options[i + 1], TlbOptions.physBits);
+		} else if (s == "--timing") {
+			number = parseNumber(options[i + 1], TimingOptions.enabled);
+		} else if (s == "--l2-banks") {
+			number = parseNumber(options[i + 1], TimingOptions.l2Banks);
+		} else if (s == "--l2-bank-cyc") {
+			number = parseNumber(options[i + 1], TimingOptions.bankCyc);
+		} else if (s == "--l1-mshrs") {
+			number = parseNumber(options[i + 1], TimingOptions.l1Mshrs);
+		} else if (s == "--l2-mshrs") {
+			number = parseNumber(options[i + 1], TimingOptions.l2Mshrs);
+		} else if (s == "--dram") {
+			number = parseNumber(options[i + 1], DramOptions.enabled);
+		} else if (s == "--dram-channels") {
+			number = parseNumber(options[i + 1], DramOptions.channels);
+		} else if (s == "--dram-ranks") {
+			number = parseNumber(options[i + 1], DramOptions.ranks);
+		} else if (s == "--dram-banks") {
+			number = parseNumber(options[i + 1], DramOptions.banks);
+		} else if (s == "--dram-row-bits") {
+			number = parseNumber(options[i + 1], DramOptions.rowBits);
+		} else if (s == "--dram-page") {
+			names = PAGE_POLICY_NAMES;
+			number = parseName(options[i + 1], names, DramPage);
+		} else if (s == "--trcd") {
+			number = parseNumber(options[i + 1], DramOptions.tRCD);
+		} else if (s == "--tcl") {
+			number = parseNumber(options[i + 1], DramOptions.tCL);
+		} else if (s == "--trp") {
+			number = parseNumber(options[i + 1], DramOptions.tRP);
+		} else if (s == "--tburst") {
+			number = parseNumber(options[i + 1], DramOptions.tBurst);
+		} else if (s == "--dram-write-queue") {
+			number = parseNumber(options[i + 1], DramOptions.writeQueue);
+		} else if (s == "--vic-cache") {
+			// The victim cache is not modelled, the option is accepted for compatibility with the tests
+		} else if (s == "--preset" || s == "--config") {
+			// Already expanded into the options before the command line ones
+		} else {
+			fprintf(err, "Unknown option %s (%s)\n", options[i], origins[i / 2].c_str());
+			return 0;
+		}
+		if (!number && names != NULL) {
+			fprintf(err, "Option %s takes", options[i]);
+			for (unsigned j = 0; names[j] != NULL; j++)
+				fprintf(err, "%s %s", j == 0 ? "" : names[j + 1] == NULL ? " or" : ",", names[j]);
+			fprintf(err, ", or the number of one, not %s (%s)\n", options[i + 1], origins[i / 2].c_str());
+			return 0;
+		}
+		if (!number) {
+			fprintf(err, "Option %s takes a number, not %s (%s)\n", options[i], options[i + 1],
+					origins[i / 2].c_str());
+			return 0;
+		}
+	}
+
+	Simulation sim;
+	sim.out = out;
+	sim.err = err;
+	sim.profiler = NULL;
+	sim.reuse = NULL;
+	sim.sampler = NULL;
+	sim.keepTrace = MrcVerify;
+	sim.reportEvery = ReportEvery;
+	sim.attributionTop = Attribution;
+	TlbOptions.mapping = PAGE_MAPPING(PageMap);
+	DramOptions.policy = PAGE_POLICY(DramPage);
+	const char* geometry = geometryError(BSize, L1Size, L1Assoc, L2Size, L2Assoc, TlbOptions);
+	if (geometry != NULL) {
+		fprintf(err, "%s\n", geometry);
+		return 0;
+	}
+	bool checkpoint = SaveState != NULL || LoadState != NULL;
+	const char* invalid = NULL;
+	if (RegionBits >= 64)
+		invalid = "--region-bits must be below 64";
+	else if (ReuseSampleBits >= 32)
+		invalid = "--reuse-sample-bits must be below 32";
+	else if (TlbOptions.pageBits >= 64)
+		invalid = "--page-bits must be below 64";
+	else if (TlbOptions.physBits <= TlbOptions.pageBits || TlbOptions.physBits > 64)
+		invalid = "--phys-bits must be above --page-bits and at most 64";
+	else if (PageMap > SCATTERED_MAPPING)
+		invalid = "--page-map must be identity, sequential or scattered";
+	else if (TimingOptions.l2Banks > L2Size - BSize - L2Assoc)
+		invalid = "--l2-banks cannot be more than the L2 set bits";
+	else if (TimingOptions.l1Mshrs == 0 || TimingOptions.l1Mshrs > MSHR_MAX || TimingOptions.l2Mshrs == 0 ||
+			 TimingOptions.l2Mshrs > MSHR_MAX)
+		invalid = "--l1-mshrs and --l2-mshrs must be between 1 and 64";
+	else if (DramPage > CLOSED_PAGE)
+		invalid = "--dram-page must be open or closed";
+	else if (DramOptions.channels + DramOptions.ranks + DramOptions.banks > 16)
+		invalid = "--dram-channels, --dram-ranks and --dram-banks add up to more than 16";
+	else if (DramOptions.rowBits < BSize || DramOptions.rowBits >= 64)
+		invalid = "--dram-row-bits must be at least --bsize and below 64";
+	else if (DramOptions.writeQueue == 0)
+		invalid = "--dram-write-queue must be at least 1";
+	else if (Sectors > MAX_SECTORS || Sectors > BSize)
+		invalid = "--sectors must be at most 5 and at most --bsize";
+	else if (L1Index > SKEWED || L2Index > SKEWED)
+		invalid = "--l1-index and --l2-index must be bit, xor, prime or skew";
+	else if (WriteBufferDepth == 0 || WriteBufferDepth > WRITE_BUFFER_MAX)
+		invalid = "--write-buffer must be between 1 and 64";
+	else if (L2Insertion > DIP_INSERTION)
+		invalid = "--l2-insertion must be lru, bip or dip";
+	else if (BypassRegion < BSize || BypassRegion >= 64)
+		invalid = "--bypass-region must be at least --bsize and below 64";
+	else if (Schedule > WEIGHTED)
+		invalid = "--schedule must be round-robin, timestamp or weighted";
+	else if (Schedule == WEIGHTED && !validWeights(Weights, Traces.size() + 1))
+		invalid = "--weights needs a positive weight for every trace";
+	else if (!WayMasksParsed || (!WayMasks.empty() && !validWayMasks(WayMasks, Traces.size() + 1, L2Assoc)))
+		invalid = "--way-masks needs a non-empty mask of L2 ways for every trace in every partitioning";
+	else if (!WayMasks.empty() && L2Index == SKEWED)
+		invalid = "--way-masks needs the sets of a non-skewed L2";
+	// private L1s are not part of a checkpoint, and the classifiers and samplers follow a single L1
+	else if (!Traces.empty() && (checkpoint || ClassifyMisses || SetSample > 1 || SamplePeriod))
+		invalid = "--trace cannot be combined with checkpoints, --classify-misses or sampling";
+	// sector masks, DRAM, write buffer, insertion and partition state and hashed sets are not part of a checkpoint
+	else if (checkpoint && (Sectors || DramOptions.enabled || L1Index != BIT_SELECT || L2Index != BIT_SELECT ||
+							L1WriteThrough || L2Insertion != LRU_INSERTION || L2Bypass || !WayMasks.empty()))
+		invalid = "checkpoints only hold whole lines of bit selected sets of an LRU hierarchy";
+	// the TLB, timing, classifier, attribution, heatmap and sampler state would restart empty after a load
+	else if (checkpoint && (TlbOptions.enabled || TimingOptions.enabled || ClassifyMisses || Attribution ||
+							Heatmap != NULL || SetSample > 1 || SamplePeriod))
+		invalid = "checkpoints cannot be combined with --tlb, --timing, --classify-misses, --attribution, --heatmap "
+				  "or sampling";
+	// sectors, insertion, bypass and skewed sets give every line a way of its set, which an entry holds in 16 bits
+	else if (((Sectors || L1Index == SKEWED) && L1Assoc > MAX_WAY_BITS) ||
+			 ((Sectors || L2Index == SKEWED || L2Insertion != LRU_INSERTION || L2Bypass) && L2Assoc > MAX_WAY_BITS))
+		invalid = "--sectors, --l2-insertion, --l2-bypass and skewed sets need levels of at most 65536 ways";
+	// insertion positions need the LRU order of a set, and write-through stores need the block in L2
+	else if ((L2Insertion != LRU_INSERTION || L2Bypass) && L2Index == SKEWED)
+		invalid = "--l2-insertion and --l2-bypass need the sets of a non-skewed L2";
+	else if (L2Bypass && L1WriteThrough)
+		invalid = "--l2-bypass cannot be combined with --l1-write-through";
+	// sets are sampled by their low block number bits, and a skewed level has no sets for the heatmap
+	else if ((L1Index != BIT_SELECT || L2Index != BIT_SELECT) && SetSample > 1)
+		invalid = "--set-sample needs bit selected sets";
+	else if ((L1Index == SKEWED || L2Index == SKEWED) && Heatmap != NULL)
+		invalid = "the heatmap needs the sets of non-skewed levels";
+	// sets are sampled by the trace address, which only indexes the caches when pages are not remapped
+	else if (SetSample > 1 && TlbOptions.enabled && TlbOptions.mapping != IDENTITY_MAPPING)
+		invalid = "--set-sample needs --page-map identity when the TLB is on";
+	else if (!FormatParsed)
+		invalid = "--format must be text, json, csv or binary";
+	// a results file takes a record, and only text is printed to the output
+	else if (Results != NULL && Format == TEXT_RESULTS)
+		invalid = "--results needs --format json, csv or binary";
+	else if (Results == NULL && Format == BINARY_RESULTS)
+		invalid = "--format binary needs a --results file";
+	if (invalid != NULL) {
+		fprintf(err, "Error in arguments: %s\n", invalid);
+		return 0;
+	}
+#ifndef CACHE_HEATMAP
+	if (Heatmap != NULL) {
+		fprintf(err, "The heatmap needs a build with CACHE_HEATMAP\n");
+		return 0;
+	}
+#endif
+	if (SetSample > 1 || SamplePeriod) {
+		// sample the sets of the hierarchy with fewer sets, whole sets of the other one follow
+		unsigned l1SetBits = L1Size - BSize - L1Assoc, l2SetBits = L2Size - BSize - L2Assoc;
+		sim.sampler = new Sampler(SetSample, SamplePeriod, SampleWindow, SampleWarmup,
+								  l1SetBits < l2SetBits ? l1SetBits : l2SetBits, BSize);
+		if (sim.sampler->getSampledSets() == 0 || (SamplePeriod && SampleWindow == 0)) {
+			fprintf(err, "Sampling leaves nothing to measure\n");
+			delete sim.sampler;
+			return 0;
+		}
+	}
+
+	// File
+	// Assuming it is the first argument, opened once every option is known to be valid: reading its format
+	// waits for a live producer
+	// Plain or compressed trace, the format is detected from its first bytes
+	// "-", a named pipe or a UNIX socket are simulated while the trace is produced
+	char* fileString = argv[1];
+	string openError;
+	TraceSource* file = trace != NULL ? trace : TraceReader::open(fileString, openError);
+	if (file == NULL) {
+		// File doesn't exist or some other error
+		fprintf(err, "%s\n", openError.c_str());
+		delete sim.sampler;
+		return 0;
+	}
+	sim.file = file;
+	vector<TraceSource*> sources(1, file);
+	for (unsigned int i = 0; i < Traces.size(); i++) {
+		TraceSource* source = TraceReader::open(Traces[i], openError);
+		if (source == NULL) {
+			fprintf(err, "%s\n", openError.c_str());
+			for (unsigned int j = 1; j < sources.size(); j++)
+				delete sources[j];
+			delete sim.sampler;
+			if (file != trace)
+				delete file;
+			return 0;
+		}
+		sources.push_back(source);
+	}
+	sim.scheduler = NULL;
+	if (!Traces.empty()) {
+		sim.scheduler = new TraceScheduler(sources, SCHEDULE(Schedule), Weights);
+		sim.file = sim.scheduler;
+	}
+	sim.loadState = LoadState;
+	sim.saveState = SaveState;
+	sim.heatmap = Heatmap;
+	sim.heatmapBinary = HeatmapBinary;
+	sim.traceName = fileString;
+	sim.format = RESULT_FORMAT(Format);
+	sim.results = Results;
+	sim.runtime = ResultsRuntime;
+	if (Mrc || MrcVerify)
+		sim.profiler = new StackDistanceProfiler(L1Size > L2Size ? L1Size : L2Size, BSize);
+	if (ReuseProfile)
+		sim.reuse = new ReuseProfiler(BSize, ReuseSampleBits, WssWindow);
+
+	// 32 bit addresses unless asked otherwise, widened on the first wide address or by a 64 bit checkpoint
+	CacheConfig config;
+	config.memCyc = MemCyc;
+	config.bSize = BSize;
+	config.wrAllocate = WrAlloc;
+	config.l1Size = L1Size;
+	config.l1Assoc = L1Assoc;
+	config.l1Cyc = L1Cyc;
+	config.l2Size = L2Size;
+	config.l2Assoc = L2Assoc;
+	config.l2Cyc = L2Cyc;
+	config.sectors = Sectors;
+	config.l1WriteThrough = L1WriteThrough;
+	config.writeBuffer = WriteBufferDepth;
+	config.writeBufferCyc = WriteBufferCyc;
+	config.l1Index = INDEX_FUNCTION(L1Index);
+	config.l2Index = INDEX_FUNCTION(L2Index);
+	config.l2Insertion = INSERTION_POLICY(L2Insertion);
+	config.l2Bypass = L2Bypass;
+	config.bypassRegionBits = BypassRegion;
+	config.traces = sources.size();
+	config.wayMasks = WayMasks;
+	config.repartitionInterval = RepartitionEvery;
+	config.addressBits = AddrBits;
+	config.classifyMisses = ClassifyMisses;
+	config.attribute = Attribution > 0;
+	config.regionBits = RegionBits;
+	config.attributionSlots = AttributionSlots;
+	config.heatmap = Heatmap != NULL;
+	config.tlb = TlbOptions;
+	config.timing = TimingOptions;
+	config.dram = DramOptions;
+	CacheSimulator cache(config);
+	bool ok = simulate(cache, sim);
+
+	if (ok && ReuseProfile)
+		sim.reuse->print(out);
+	if (ok && Mrc)
+		sim.profiler->print(out);
+	if (ok && MrcVerify && verifyStackDistances(*sim.profiler, sim.trace, BSize, out))
+		fprintf(out, "MRC verified\n");
+	delete sim.profiler;
+	delete sim.reuse;
+	delete sim.sampler;
+	delete sim.scheduler;
+	for (unsigned int i = 1; i < sources.size(); i++)
+		delete sources[i];
+	if (file != trace)
+		delete file;
+
+	return 0;
+}
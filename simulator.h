@@ -0,0 +1,13 @@
+//
+// The simulator behind the cacheSim command line: option parsing, the simulation loop and the report.
+//
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdio.h>
+#include "traceReader.h"
+
+int runCacheSim(int argc, char **argv, FILE* out, FILE* err, TraceSource* trace);
+
+#endif // SIMULATOR_H
@@ -0,0 +1,174 @@
+//
+// Single pass LRU stack distance (Mattson) profiling for every power of two cache geometry.
+//
+
+#include "cache.h"
+#include "stackDistance.h"
+
+/**
+ * adds a new last position to the tree
+ * @param value the value at the new position
+ */
+void FenwickTree::append(int value){
+    unsigned int index = tree.size();
+    unsigned int low = index - (index & -index);
+    int sum = value;
+    for (unsigned int i = index - 1; i > low; i -= i & -i)
+        sum += tree[i];
+    tree.push_back(sum);
+}
+
+/**
+ * adds delta to the value at a given position
+ * @param index 1-based position
+ * @param delta value to add
+ */
+void FenwickTree::add(unsigned int index, int delta){
+    for (; index < tree.size(); index += index & -index)
+        tree[index] += delta;
+}
+
+/**
+ * @param index 1-based position
+ * @return the sum of the values at positions 1 to index
+ */
+int FenwickTree::prefix(unsigned int index) const{
+    int sum = 0;
+    for (; index > 0; index -= index & -index)
+        sum += tree[index];
+    return sum;
+}
+
+
+/**
+ * @param maxSize log2 of the largest cache size (in bytes) to profile
+ * @param bSize log2 of the block size
+ */
+StackDistanceProfiler::StackDistanceProfiler(unsigned int maxSize, unsigned int bSize) :
+        bSize(bSize),
+        blockBits(maxSize > bSize ? maxSize - bSize : 0),
+        sets(blockBits + 1),
+        lastAccess(blockBits + 1),
+        histogram(blockBits + 1, vector<unsigned long long>(blockBits + 2, 0)),
+        coldMisses(blockBits + 1, 0),
+        accesses(0){
+    for (unsigned int setBits = 0; setBits <= blockBits; setBits++)
+        sets[setBits].resize(1u << setBits);
+}
+
+/**
+ * renumbers the local timestamps of a set so that only the latest access of every block is kept
+ * @param stack set to compact
+ * @param last map from block to its latest local timestamp
+ */
+void StackDistanceProfiler::compact(SetStack& stack, unordered_map<uint64_t, uint32_t>& last){
+    FenwickTree marks;
+    vector<uint64_t> owner;
+    owner.reserve(stack.live);
+    for (unsigned int time = 1; time <= stack.owner.size(); time++){
+        uint64_t block = stack.owner[time - 1];
+        uint32_t& latest = last[block];
+        if (latest != time)
+            continue;
+        owner.push_back(block);
+        marks.append(1);
+        latest = owner.size();
+    }
+    stack.marks = marks;
+    stack.owner.swap(owner);
+}
+
+/**
+ * records an access in every profiled geometry
+ * @param address accessed address
+ */
+void StackDistanceProfiler::access(uint64_t address){
+    accesses++;
+    uint64_t block = address >> bSize;
+    for (unsigned int setBits = 0; setBits <= blockBits; setBits++){
+        SetStack& stack = sets[setBits][block & ((1u << setBits) - 1)];
+        unordered_map<uint64_t, uint32_t>& last = lastAccess[setBits];
+        unordered_map<uint64_t, uint32_t>::iterator it = last.find(block);
+        if (it == last.end()){
+            coldMisses[setBits]++;
+            stack.live++;
+        }
+        else {
+            unsigned int distance = stack.marks.prefix(stack.marks.size()) - stack.marks.prefix(it->second);
+            unsigned int bucket = 0;
+            while (distance > 0 && bucket <= blockBits){
+                distance >>= 1;
+                bucket++;
+            }
+            histogram[setBits][bucket]++;
+            stack.marks.add(it->second, -1);
+        }
+        stack.marks.append(1);
+        stack.owner.push_back(block);
+        last[block] = stack.owner.size();
+        if (stack.owner.size() >= 2 * stack.live + 64)
+            compact(stack, last);
+    }
+}
+
+/**
+ * @param setBits log2 of the number of sets
+ * @param assocBits log2 of the number of ways
+ * @return the number of misses of an LRU cache with this geometry
+ */
+unsigned long long StackDistanceProfiler::getMisses(unsigned int setBits, unsigned int assocBits) const{
+    // a hit needs a stack distance below 2^assocBits, that is a bucket of at most assocBits
+    unsigned long long misses = coldMisses[setBits];
+    for (unsigned int bucket = assocBits + 1; bucket < histogram[setBits].size(); bucket++)
+        misses += histogram[setBits][bucket];
+    return misses;
+}
+
+/**
+ * prints the miss ratio curve, one line per cache size and associativity
+ * @param out stream to print to
+ */
+void StackDistanceProfiler::print(FILE* out) const{
+    for (unsigned int sizeBlocks = 0; sizeBlocks <= blockBits; sizeBlocks++){
+        for (unsigned int assocBits = 0; assocBits <= sizeBlocks; assocBits++){
+            unsigned long long misses = getMisses(sizeBlocks - assocBits, assocBits);
+            fprintf(out, "MRC size=%u assoc=%u misses=%llu missRate=%.03f\n", sizeBlocks + bSize, assocBits,
+                    misses, accesses ? double(misses) / double(accesses) : 0.0);
+        }
+    }
+}
+
+/**
+ * cross checks the profiler against a CacheHierarchy simulation of every profiled geometry
+ * @param profiler profiler that was fed with the trace
+ * @param trace the addresses of the trace in order
+ * @param bSize log2 of the block size
+ * @param out stream the mismatches are printed to
+ * @return true if every geometry has the same number of misses
+ */
+bool verifyStackDistances(const StackDistanceProfiler& profiler, const vector<uint64_t>& trace, unsigned int bSize,
+                          FILE* out){
+    bool ok = true;
+    for (unsigned int size = bSize; size <= profiler.getMaxSize(); size++){
+        for (unsigned int assocBits = 0; assocBits <= size - bSize; assocBits++){
+            CacheHierarchy<uint64_t> hierarchy(size, assocBits, 0, bSize);
+            unsigned long long misses = 0;
+            for (unsigned int i = 0; i < trace.size(); i++){
+                if (!hierarchy.snoop(trace[i])){
+                    misses++;
+                    if (hierarchy.isSetFull(trace[i]))
+                        hierarchy.removeLast(trace[i]);
+                    hierarchy.add(trace[i]);
+                }
+                hierarchy.updateByLRU(trace[i]);
+            }
+            unsigned long long expected = profiler.getMisses(size - bSize - assocBits, assocBits);
+            if (misses != expected){
+                fprintf(out, "MRC mismatch size=%u assoc=%u simulated=%llu profiled=%llu\n", size, assocBits,
+                        misses, expected);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
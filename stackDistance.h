@@ -0,0 +1,68 @@
+//
+// Single pass LRU stack distance (Mattson) profiling for every power of two cache geometry.
+//
+
+#ifndef STACK_DISTANCE_H
+#define STACK_DISTANCE_H
+
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include <unordered_map>
+
+using namespace std;
+
+/**
+ * a Fenwick (binary indexed) tree over access timestamps that can grow by appending new timestamps at its end
+ */
+class FenwickTree{
+    vector<int> tree;   // 1-based, tree[i] holds the sum of (i - lowbit(i), i]
+public:
+    FenwickTree() : tree(1, 0){}
+    unsigned int size() const{
+        return tree.size() - 1;
+    }
+    void append(int value);
+    void add(unsigned int index, int delta);
+    int prefix(unsigned int index) const;
+};
+
+/**
+ * computes the LRU stack distance of every access inside its set for every number of sets at once.
+ * each set keeps a Fenwick tree over its local access timestamps in which only the latest access of every block
+ * is marked, so the stack distance of an access is the number of marks after the previous access to the block.
+ * a single pass gives the number of misses of every cache with 2^setBits sets and 2^assocBits ways.
+ */
+class StackDistanceProfiler{
+    struct SetStack{
+        FenwickTree marks;
+        vector<uint64_t> owner;     // block accessed at every local timestamp
+        unsigned int live;          // number of distinct blocks seen by the set
+        SetStack() : live(0){}
+    };
+    const unsigned int bSize;
+    const unsigned int blockBits;   // log2 of the largest profiled cache size in blocks
+    vector<vector<SetStack> > sets;                         // indexed by number of set bits, then by set
+    vector<unordered_map<uint64_t, uint32_t> > lastAccess;  // per number of set bits: block -> local timestamp
+    vector<vector<unsigned long long> > histogram;          // per number of set bits: log2 distance buckets
+    vector<unsigned long long> coldMisses;                  // per number of set bits
+    unsigned long long accesses;
+
+    void compact(SetStack& stack, unordered_map<uint64_t, uint32_t>& last);
+public:
+    StackDistanceProfiler(unsigned int maxSize, unsigned int bSize);
+    void access(uint64_t address);
+    unsigned long long getMisses(unsigned int setBits, unsigned int assocBits) const;
+    unsigned long long getAccesses() const{
+        return accesses;
+    }
+    unsigned int getMaxSize() const{
+        return blockBits + bSize;
+    }
+    void print(FILE* out) const;
+};
+
+bool verifyStackDistances(const StackDistanceProfiler& profiler, const vector<uint64_t>& trace, unsigned int bSize,
+                          FILE* out);
+
+#endif // STACK_DISTANCE_H
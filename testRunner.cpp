@@ -0,0 +1,188 @@
+//
+// Runs the regression tests (tests/test*.command) inside one process on all cores.
+// Every trace is parsed once and shared by all the commands that use it, and the output of every command is
+// compared in memory with its expected .OURS output (or .out when there is no .OURS file).
+//
+// Usage: testRunner [tests directory] [-j threads]
+//
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include "simulator.h"
+
+using namespace std;
+
+/**
+ * a trace parsed once for every command that uses it
+ */
+struct SharedTrace{
+    vector<TraceRecord> records;
+    TRACE_STATUS end;
+    bool loaded;
+};
+
+/**
+ * a single regression test: a cacheSim command line and its expected output
+ */
+struct TestCase{
+    string name;
+    vector<string> args;
+    string expected;
+    SharedTrace* trace;
+    bool passed;
+};
+
+/**
+ * @param path file to read
+ * @param content set to the content of the file
+ * @return false if the file cannot be read
+ */
+static bool readFile(const string& path, string& content){
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+    content.clear();
+    char buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        content.append(buffer, size);
+    fclose(file);
+    return true;
+}
+
+/**
+ * @return the number in a test name such as "test12", so tests are listed in numeric order
+ */
+static long testNumber(const string& name){
+    return strtol(name.c_str() + 4, NULL, 10);
+}
+
+static bool byTestNumber(const TestCase& a, const TestCase& b){
+    return testNumber(a.name) < testNumber(b.name);
+}
+
+/**
+ * runs a test in process and compares its output with the expected one
+ * @param test test to run
+ */
+static void runTest(TestCase& test){
+    vector<char*> argv;
+    for (unsigned int i = 0; i < test.args.size(); i++)
+        argv.push_back(&test.args[i][0]);
+    argv.push_back(NULL);
+
+    char* output = NULL;
+    size_t outputSize = 0;
+    char* errors = NULL;
+    size_t errorsSize = 0;
+    FILE* out = open_memstream(&output, &outputSize);
+    FILE* err = open_memstream(&errors, &errorsSize);
+    RecordedTrace recorded(test.trace->records, test.trace->end);
+    // a trace that could not be parsed is opened by the simulator itself, so it reports the error
+    runCacheSim(argv.size() - 1, argv.data(), out, err, test.trace->loaded ? &recorded : NULL);
+    fclose(out);
+    fclose(err);
+    test.passed = string(output, outputSize) == test.expected;
+    free(output);
+    free(errors);
+}
+
+/**
+ * runs a function on every index of a range using a pool of threads
+ * @param count size of the range
+ * @param threads number of threads
+ * @param job function called with every index once
+ */
+template <typename Job>
+static void parallelFor(size_t count, unsigned int threads, Job job){
+    atomic<size_t> next(0);
+    vector<thread> pool;
+    for (unsigned int i = 0; i < threads; i++){
+        pool.push_back(thread([&]{
+            for (size_t index = next++; index < count; index = next++)
+                job(index);
+        }));
+    }
+    for (unsigned int i = 0; i < pool.size(); i++)
+        pool[i].join();
+}
+
+int main(int argc, char **argv) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    string directory = "tests";
+    unsigned int threads = thread::hardware_concurrency();
+    for (int i = 1; i < argc; i++){
+        string arg(argv[i]);
+        if (arg == "-j" && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else
+            directory = arg;
+    }
+    if (threads == 0)
+        threads = 1;
+
+    DIR* dir = opendir(directory.c_str());
+    if (dir == NULL){
+        fprintf(stderr, "Cannot open %s\n", directory.c_str());
+        return 1;
+    }
+    vector<TestCase> tests;
+    map<string, SharedTrace> traces;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL){
+        string file(entry->d_name);
+        const string suffix = ".command";
+        if (file.compare(0, 4, "test") != 0 || file.size() <= suffix.size() ||
+            file.compare(file.size() - suffix.size(), suffix.size(), suffix) != 0)
+            continue;
+        TestCase test;
+        test.name = file.substr(0, file.size() - suffix.size());
+        string prefix = directory + "/" + test.name, command;
+        if (!readFile(prefix + ".command", command) ||
+            (!readFile(prefix + ".OURS", test.expected) && !readFile(prefix + ".out", test.expected)))
+            continue;
+        char* save;
+        for (char* token = strtok_r(&command[0], " \t\r\n", &save); token != NULL;
+             token = strtok_r(NULL, " \t\r\n", &save))
+            test.args.push_back(token);
+        if (test.args.size() < 2)
+            continue;
+        test.trace = &traces[test.args[1]];
+        tests.push_back(test);
+    }
+    closedir(dir);
+    sort(tests.begin(), tests.end(), byTestNumber);
+
+    vector<pair<const string, SharedTrace>*> unique;
+    for (map<string, SharedTrace>::iterator it = traces.begin(); it != traces.end(); ++it)
+        unique.push_back(&*it);
+    parallelFor(unique.size(), threads, [&](size_t i){
+        string error;
+        unique[i]->second.loaded = TraceReader::readAll(unique[i]->first.c_str(), unique[i]->second.records,
+                                                        unique[i]->second.end, error);
+    });
+    parallelFor(tests.size(), threads, [&](size_t i){
+        runTest(tests[i]);
+    });
+
+    unsigned int failed = 0;
+    for (unsigned int i = 0; i < tests.size(); i++){
+        if (!tests[i].passed){
+            printf("The test %s/%s didnt pass\n", directory.c_str(), tests[i].name.c_str());
+            failed++;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("Ran %zu tests on %zu traces with %u threads in %.3f s: %zu passed, %u failed\n", tests.size(),
+           traces.size(), threads, seconds, tests.size() - failed, failed);
+    return failed == 0 && !tests.empty() ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+//
+// Timing mode: latencies with L2 bank contention and non-blocking levels with a bounded number of outstanding misses.
+//
+
+#include "timing.h"
+
+/**
+ * frees the entries whose data is back
+ * @param now current cycle
+ */
+void MshrFile::retire(unsigned long long now){
+    for (unsigned int i = 0; i < count; ){
+        if (readyAt[i] <= now){    // completed, the last entry takes its place
+            count--;
+            blocks[i] = blocks[count];
+            readyAt[i] = readyAt[count];
+        }
+        else
+            i++;
+    }
+}
+
+/**
+ * @param block block number of a miss
+ * @param now cycle of the miss
+ * @return the cycle the block arrives when it is still in flight at now (the miss merges), 0 otherwise
+ */
+unsigned long long MshrFile::lookup(uint64_t block, unsigned long long now) const{
+    for (unsigned int i = 0; i < count; i++){
+        if (blocks[i] == block && readyAt[i] > now)
+            return readyAt[i];
+    }
+    return 0;
+}
+
+/**
+ * @param now cycle a new miss is ready to start
+ * @return the cycle it can start, later than now when every MSHR is busy at now
+ */
+unsigned long long MshrFile::freeAt(unsigned long long now) const{
+    unsigned int busy = 0;
+    unsigned long long earliest = 0;
+    for (unsigned int i = 0; i < count; i++){
+        if (readyAt[i] > now){
+            busy++;
+            earliest = busy == 1 || readyAt[i] < earliest ? readyAt[i] : earliest;
+        }
+    }
+    return busy < capacity ? now : earliest;
+}
+
+/**
+ * @param block block number of the miss
+ * @param start cycle the miss starts, as given by freeAt
+ * @param ready cycle its data is back
+ */
+void MshrFile::insert(uint64_t block, unsigned long long start, unsigned long long ready){
+    retire(start);
+    blocks[count] = block;
+    readyAt[count] = ready;
+    count++;
+}
+
+
+/**
+ * @param config banks and MSHRs of both levels
+ * @param l1Cyc L1 latency
+ * @param l2Cyc L2 latency
+ * @param bSize log2 of the block size
+ * @param l2SetBits set bits of L2, the low ones choose the bank
+ */
+TimingModel::TimingModel(const TimingConfig& config, unsigned int l1Cyc, unsigned int l2Cyc, unsigned int bSize,
+                         unsigned int l2SetBits) :
+        config(config),
+        l1Cyc(l1Cyc),
+        l2Cyc(l2Cyc),
+        bSize(bSize),
+        l2SetBits(l2SetBits),
+        bankBusyUntil(1u << config.l2Banks, 0),
+        l1Mshrs(config.l1Mshrs),
+        l2Mshrs(config.l2Mshrs),
+        now(0),
+        lastDone(0),
+        accesses(0),
+        totalLatency(0),
+        bankConflicts(0),
+        bankWait(0),
+        mshrWait(0),
+        l1Merges(0),
+        l2Merges(0){}
+
+/**
+ * @param address accessed (physical) address
+ * @return the L2 bank of the address, chosen by the low set bits
+ */
+unsigned int TimingModel::bank(uint64_t address) const{
+    uint64_t set = getSet(address, l2SetBits, bSize) >> bSize;
+    return set & (bankBusyUntil.size() - 1);
+}
+
+/**
+ * moves time to the issue of the next access
+ * @param kind whether time is an absolute cycle, a gap after the previous access or missing
+ * @param time the cycle or the gap, an access without one waits for the previous one like a blocking cache
+ */
+void TimingModel::issue(TRACE_TIME kind, uint64_t time){
+    if (accesses == 0 && kind != AT_CYCLE)
+        return;     // the first access is issued at cycle 0
+    if (kind == AT_CYCLE)
+        now = time > now ? time : now;  // a record from the past is issued now
+    else if (kind == AFTER_GAP)
+        now += time;
+    else
+        now = lastDone > now ? lastDone : now;
+}
+
+/**
+ * the cycle a miss of the current access in both levels would reach the memory, for the backends that depend on it
+ * @param address accessed (physical) address
+ * @return the issue cycle after the L1 lookup, the waits for an L1 MSHR and for the L2 bank, the L2 lookup and the
+ *         wait for an L2 MSHR
+ */
+unsigned long long TimingModel::memoryCycle(uint64_t address) const{
+    unsigned long long start = l1Mshrs.freeAt(now + l1Cyc);
+    unsigned long long busyUntil = bankBusyUntil[bank(address)];
+    start = (busyUntil > start ? busyUntil : start) + l2Cyc;
+    return l2Mshrs.freeAt(start);
+}
+
+/**
+ * @param address accessed (physical) address
+ * @param level the level that served the access in the functional caches
+ * @param memLatency latency of the memory when the access missed L2
+ * @return the latency of the access, including the time it waited for an L2 bank, for an MSHR and for the data
+ *         of a miss in flight to its block
+ */
+unsigned long long TimingModel::access(uint64_t address, HIERARCHY level, unsigned long long memLatency){
+    accesses++;
+    uint64_t block = address >> bSize;
+    unsigned long long done = now + l1Cyc;
+    unsigned long long inFlight = l1Mshrs.lookup(block, now);
+    if (inFlight){
+        l1Merges++;
+        done = inFlight > done ? inFlight : done;
+    }
+    else if (level != L1){
+        unsigned long long start = l1Mshrs.freeAt(done);
+        mshrWait += start - done;
+        unsigned long long missStart = start;
+        unsigned long long& busyUntil = bankBusyUntil[bank(address)];
+        if (busyUntil > start){
+            bankConflicts++;
+            bankWait += busyUntil - start;
+            start = busyUntil;
+        }
+        busyUntil = start + (config.bankCyc ? config.bankCyc : l2Cyc);
+        done = start + l2Cyc;
+        inFlight = l2Mshrs.lookup(block, done);
+        if (inFlight){
+            l2Merges++;
+            done = inFlight > done ? inFlight : done;
+        }
+        else if (level == MEM){
+            start = l2Mshrs.freeAt(done);
+            mshrWait += start - done;
+            done = start + memLatency;
+            l2Mshrs.insert(block, start, done);
+        }
+        l1Mshrs.insert(block, missStart, done);
+    }
+    lastDone = done;
+    totalLatency += done - now;
+    return done - now;
+}
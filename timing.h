@@ -0,0 +1,93 @@
+//
+// Timing mode: latencies with L2 bank contention and non-blocking levels with a bounded number of outstanding misses.
+//
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <vector>
+#include <stdint.h>
+#include "cache.h"
+#include "traceReader.h"
+
+using namespace std;
+
+static const unsigned int MSHR_MAX = 64;
+
+/**
+ * the options of the timing mode
+ */
+struct TimingConfig{
+    bool enabled;
+    unsigned int l2Banks;       // log2 of the number of L2 banks, selected by the low set bits
+    unsigned int bankCyc;       // cycles a bank stays busy per access, 0 uses the L2 latency
+    unsigned int l1Mshrs;       // outstanding L1 misses (to L2), at most MSHR_MAX
+    unsigned int l2Mshrs;       // outstanding L2 misses (to memory), at most MSHR_MAX
+    TimingConfig() : enabled(false), l2Banks(0), bankCyc(0), l1Mshrs(8), l2Mshrs(8){}
+};
+
+/**
+ * the miss status holding registers of a level: a small fixed-size associative array of the blocks in flight and
+ * the cycle each of them completes. a miss to a block in flight merges with it, a full file makes a new miss wait
+ * for the earliest completion.
+ */
+class MshrFile{
+    uint64_t blocks[MSHR_MAX];
+    unsigned long long readyAt[MSHR_MAX];
+    const unsigned int capacity;
+    unsigned int count;
+
+    void retire(unsigned long long now);
+public:
+    explicit MshrFile(unsigned int capacity) : capacity(capacity < 1 ? 1 : capacity > MSHR_MAX ? MSHR_MAX : capacity),
+                                               count(0){}
+    unsigned long long lookup(uint64_t block, unsigned long long now) const;
+    unsigned long long freeAt(unsigned long long now) const;
+    void insert(uint64_t block, unsigned long long start, unsigned long long ready);
+};
+
+/**
+ * turns the level that served every access into a latency. accesses are issued at the cycle given by the trace,
+ * L2 is split into banks that serve one access at a time, and the misses of both levels need a free MSHR.
+ * the functional caches fill a block as soon as it misses, so an access to a block whose fill is still in flight
+ * is a secondary miss: it merges with the outstanding MSHR and waits for its data instead of paying again.
+ */
+class TimingModel{
+    const TimingConfig config;
+    const unsigned int l1Cyc;
+    const unsigned int l2Cyc;
+    const unsigned int bSize;
+    const unsigned int l2SetBits;
+    vector<unsigned long long> bankBusyUntil;
+    MshrFile l1Mshrs;
+    MshrFile l2Mshrs;
+    unsigned long long now;     // issue cycle of the current access
+    unsigned long long lastDone;    // completion cycle of the previous access
+
+    unsigned int bank(uint64_t address) const;
+public:
+    unsigned long long accesses;
+    unsigned long long totalLatency;
+    unsigned long long bankConflicts;
+    unsigned long long bankWait;
+    unsigned long long mshrWait;
+    unsigned long long l1Merges;
+    unsigned long long l2Merges;
+    TimingModel(const TimingConfig& config, unsigned int l1Cyc, unsigned int l2Cyc, unsigned int bSize,
+                unsigned int l2SetBits);
+    void issue(TRACE_TIME kind, uint64_t time);
+    unsigned long long issueCycle() const{
+        return now;
+    }
+    unsigned long long memoryCycle(uint64_t address) const;
+    unsigned long long access(uint64_t address, HIERARCHY level, unsigned long long memLatency);
+    /**
+     * delays the completion of the current access, for a store waiting for the write buffer
+     */
+    void stall(unsigned long long cycles){
+        lastDone += cycles;
+        totalLatency += cycles;
+    }
+};
+
+#endif // TIMING_H
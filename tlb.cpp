@@ -0,0 +1,71 @@
+//
+// Two level TLB and virtual to physical page mapping in front of the cache hierarchy.
+//
+
+#include "tlb.h"
+
+/**
+ * @param config geometry, timing and page mapping of the TLBs
+ */
+Tlb::Tlb(const TlbConfig& config) : config(config),
+                                    l1(config.l1Size, config.l1Assoc, config.l1Cyc, 0),
+                                    l2(config.l2Size, config.l2Assoc, config.l2Cyc, 0),
+                                    touchedPages(0),
+                                    accesses(0), l1Misses(0), l2Misses(0), cycles(0), overflowPages(0){}
+
+/**
+ * @param page virtual page number
+ * @return the physical frame of the page, given on its first touch. once physical memory is used up the frames
+ *         continue past its end and are counted in overflowPages, so distinct pages never share a frame
+ */
+uint64_t Tlb::frameOf(uint64_t page){
+    if (config.mapping == IDENTITY_MAPPING)
+        return page;
+    unordered_map<uint64_t, uint64_t>::iterator it = frames.find(page);
+    if (it != frames.end())
+        return it->second;
+    unsigned int frameBits = config.physBits - config.pageBits;    // positive, checked as the options are loaded
+    uint64_t mask = frameBits >= 64 ? ~0ull : (1ull << frameBits) - 1;
+    uint64_t frame = touchedPages++;
+    if (frame > mask)
+        overflowPages++;
+    else if (config.mapping == SCATTERED_MAPPING){
+        // odd multipliers and xor-shifts are bijections modulo 2^frameBits, so frames stay distinct
+        frame = (frame * 0x9e3779b97f4a7c15ull) & mask;
+        frame ^= frame >> (frameBits / 2 + 1);
+        frame = (frame * 0xbf58476d1ce4e5b9ull) & mask;
+    }
+    frames[page] = frame;
+    return frame;
+}
+
+/**
+ * looks the page of an address up in the TLBs, filling them on a miss, and charges the lookup cycles
+ * @param address virtual address
+ * @return the physical address
+ */
+uint64_t Tlb::translate(uint64_t address){
+    accesses++;
+    cycles += l1.lCyc;
+    uint64_t page = address >> config.pageBits;
+    if (l1.snoop(page))
+        l1.updateByLRU(page);
+    else {
+        l1Misses++;
+        cycles += l2.lCyc;
+        if (l2.snoop(page))
+            l2.updateByLRU(page);
+        else {
+            l2Misses++;
+            cycles += config.walkCyc;
+            if (l2.isSetFull(page))
+                l2.removeLast(page);
+            l2.add(page);
+        }
+        if (l1.isSetFull(page))
+            l1.removeLast(page);
+        l1.add(page);
+    }
+    uint64_t offset = address & ((1ull << config.pageBits) - 1);
+    return (frameOf(page) << config.pageBits) | offset;
+}
@@ -0,0 +1,59 @@
+//
+// Two level TLB and virtual to physical page mapping in front of the cache hierarchy.
+//
+
+#ifndef TLB_H
+#define TLB_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include "cache.h"
+
+using namespace std;
+
+enum PAGE_MAPPING {IDENTITY_MAPPING, SEQUENTIAL_MAPPING, SCATTERED_MAPPING};
+
+/**
+ * the geometry and timing of the TLBs, sizes are log2 of entries and associativities log2 of ways
+ */
+struct TlbConfig{
+    bool enabled;
+    unsigned int pageBits;      // log2 of the page size
+    unsigned int l1Size;
+    unsigned int l1Assoc;
+    unsigned int l1Cyc;         // paid by every access, 0 when the lookup overlaps the L1 cache
+    unsigned int l2Size;
+    unsigned int l2Assoc;
+    unsigned int l2Cyc;         // paid by every L1 TLB miss
+    unsigned int walkCyc;       // paid by every L2 TLB miss
+    PAGE_MAPPING mapping;
+    unsigned int physBits;      // log2 of the physical memory the frames are allocated from, above pageBits
+    TlbConfig() : enabled(false), pageBits(12), l1Size(6), l1Assoc(2), l1Cyc(0), l2Size(10), l2Assoc(3), l2Cyc(7),
+                  walkCyc(100), mapping(SEQUENTIAL_MAPPING), physBits(32){}
+};
+
+/**
+ * translates virtual addresses through an L1 and an L2 TLB. both levels are CacheHierarchy instances whose
+ * entries hold virtual page numbers, so they share the storage and LRU policy of the data caches.
+ * frames are given deterministically: the identity mapping keeps the page number, the sequential mapping gives
+ * frames in first-touch order and the scattered mapping permutes the first-touch order over physical memory.
+ */
+class Tlb{
+    const TlbConfig config;
+    CacheHierarchy<uint64_t> l1;
+    CacheHierarchy<uint64_t> l2;
+    unordered_map<uint64_t, uint64_t> frames;   // page table, virtual page -> physical frame
+    uint64_t touchedPages;
+
+    uint64_t frameOf(uint64_t page);
+public:
+    unsigned long long accesses;
+    unsigned long long l1Misses;
+    unsigned long long l2Misses;
+    unsigned long long cycles;
+    unsigned long long overflowPages;   // pages that did not fit in physical memory
+    explicit Tlb(const TlbConfig& config);
+    uint64_t translate(uint64_t address);
+};
+
+#endif // TLB_H
@@ -0,0 +1,598 @@
+//
+// Streaming trace input: plain or compressed (gzip / zstd / lz4) traces, parsed in place block by block.
+//
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <condition_variable>
+#include "traceReader.h"
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+using namespace std;
+
+static const size_t TRACE_BLOCK_SIZE = 1 << 20;
+static const size_t TRACE_QUEUE_BLOCKS = 4;
+
+/**
+ * a source of consecutive blocks of trace bytes
+ */
+class BlockSource{
+public:
+    virtual ~BlockSource(){}
+    /**
+     * @param data set to the start of the next block, valid until the next call
+     * @return the size of the block, 0 at the end of the input
+     */
+    virtual size_t next(const char*& data) = 0;
+    /**
+     * @return true if the input could not be read or decoded
+     */
+    virtual bool failed() const{
+        return false;
+    }
+    /**
+     * makes a next() that is blocked waiting for input, or any later one, return the end of the input.
+     * called from another thread than the one reading
+     */
+    virtual void interrupt() = 0;
+};
+
+/**
+ * reads raw bytes from a file descriptor, starting with bytes that were already read while detecting the format
+ */
+class FileSource : public BlockSource{
+    const int fd;
+    int wake[2];        // self-pipe that interrupt() writes to, so a read waiting for a live producer gives up
+    vector<char> buffer;
+    size_t pending;     // bytes at the start of buffer that were read ahead
+    bool error;
+public:
+    FileSource(int fd, const char* prefix, size_t prefixSize) : fd(fd), buffer(TRACE_BLOCK_SIZE),
+                                                                pending(prefixSize), error(false){
+        memcpy(buffer.data(), prefix, prefixSize);
+        if (pipe(wake) != 0)
+            wake[0] = wake[1] = -1;
+    }
+    ~FileSource(){
+        close(fd);
+        if (wake[0] >= 0){
+            close(wake[0]);
+            close(wake[1]);
+        }
+    }
+    size_t next(const char*& data);
+    bool failed() const{
+        return error;
+    }
+    void interrupt(){
+        if (wake[1] >= 0){
+            ssize_t written = write(wake[1], "", 1);    // a pipe that is already full wakes the reader as well
+            (void)written;
+        }
+    }
+};
+
+size_t FileSource::next(const char*& data){
+    data = buffer.data();
+    if (pending > 0){
+        size_t size = pending;
+        pending = 0;
+        return size;
+    }
+    struct pollfd ready[2] = {{fd, POLLIN, 0}, {wake[0], POLLIN, 0}};
+    while (wake[0] >= 0 && poll(ready, 2, -1) < 0){
+        if (errno != EINTR){
+            error = true;
+            return 0;
+        }
+    }
+    if (ready[1].revents)
+        return 0;   // interrupted, the input ends here
+    ssize_t size;
+    do {
+        size = read(fd, buffer.data(), buffer.size());
+    } while (size < 0 && errno == EINTR);
+    if (size < 0){
+        error = true;
+        return 0;
+    }
+    return size;
+}
+
+#ifdef HAVE_ZLIB
+/**
+ * decodes gzip (or zlib) streams, including several concatenated gzip members. an input that ends inside a member
+ * is an error
+ */
+class GzipSource : public BlockSource{
+    BlockSource* input;
+    vector<char> output;
+    z_stream stream;
+    bool drained;       // the input has ended, what inflate holds may still be flushed
+    bool end;
+    bool error;
+public:
+    explicit GzipSource(BlockSource* input) : input(input), output(TRACE_BLOCK_SIZE), drained(false), end(false),
+                                              error(false){
+        memset(&stream, 0, sizeof(stream));
+        inflateInit2(&stream, 15 + 32);     // detect the gzip or zlib header
+    }
+    ~GzipSource(){
+        inflateEnd(&stream);
+        delete input;
+    }
+    size_t next(const char*& data);
+    bool failed() const{
+        return error || input->failed();
+    }
+    void interrupt(){
+        input->interrupt();
+    }
+};
+
+size_t GzipSource::next(const char*& data){
+    data = output.data();
+    stream.next_out = (Bytef*)output.data();
+    stream.avail_out = output.size();
+    while (stream.avail_out > 0 && !end && !error){
+        if (stream.avail_in == 0 && !drained){
+            const char* in;
+            size_t size = input->next(in);
+            drained = size == 0;
+            stream.next_in = (Bytef*)in;
+            stream.avail_in = size;
+        }
+        if (drained && stream.total_in == 0){
+            end = true;     // between two members
+            break;
+        }
+        uInt room = stream.avail_out;
+        int status = inflate(&stream, Z_NO_FLUSH);
+        if (status == Z_STREAM_END)
+            inflateReset(&stream);  // another member may follow
+        else if ((status != Z_OK && status != Z_BUF_ERROR) || (drained && stream.avail_out == room))
+            error = true;   // corrupt, or cut short inside a member
+    }
+    return output.size() - stream.avail_out;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+/**
+ * decodes zstd frames. an input that ends inside a frame is an error
+ */
+class ZstdSource : public BlockSource{
+    BlockSource* input;
+    vector<char> output;
+    ZSTD_DStream* stream;
+    ZSTD_inBuffer in;
+    size_t remaining;   // 0 once the last frame is decoded and flushed
+    bool drained;       // the input has ended, what the decoder holds may still be flushed
+    bool end;
+    bool error;
+public:
+    explicit ZstdSource(BlockSource* input) : input(input), output(TRACE_BLOCK_SIZE), stream(ZSTD_createDStream()),
+                                              remaining(0), drained(false), end(false), error(false){
+        ZSTD_initDStream(stream);
+        in.src = NULL;
+        in.size = 0;
+        in.pos = 0;
+    }
+    ~ZstdSource(){
+        ZSTD_freeDStream(stream);
+        delete input;
+    }
+    size_t next(const char*& data);
+    bool failed() const{
+        return error || input->failed();
+    }
+    void interrupt(){
+        input->interrupt();
+    }
+};
+
+size_t ZstdSource::next(const char*& data){
+    data = output.data();
+    ZSTD_outBuffer out = {output.data(), output.size(), 0};
+    while (out.pos < out.size && !end && !error){
+        if (in.pos == in.size && !drained){
+            const char* block;
+            in.size = input->next(block);
+            in.src = block;
+            in.pos = 0;
+            drained = in.size == 0;
+        }
+        if (drained && remaining == 0){
+            end = true;     // between two frames
+            break;
+        }
+        size_t filled = out.pos;
+        size_t hint = ZSTD_decompressStream(stream, &out, &in);
+        if (ZSTD_isError(hint) || (drained && out.pos == filled))
+            error = true;   // corrupt, or cut short inside a frame
+        else
+            remaining = hint;
+    }
+    return out.pos;
+}
+#endif
+
+#ifdef HAVE_LZ4
+/**
+ * decodes lz4 frames
+ */
+class Lz4Source : public BlockSource{
+    BlockSource* input;
+    vector<char> output;
+    LZ4F_dctx* context;
+    const char* in;
+    size_t inSize;
+    bool end;
+    bool error;
+public:
+    explicit Lz4Source(BlockSource* input) : input(input), output(TRACE_BLOCK_SIZE), context(NULL), in(NULL),
+                                             inSize(0), end(false), error(false){
+        LZ4F_createDecompressionContext(&context, LZ4F_VERSION);
+    }
+    ~Lz4Source(){
+        LZ4F_freeDecompressionContext(context);
+        delete input;
+    }
+    size_t next(const char*& data);
+    bool failed() const{
+        return error || input->failed();
+    }
+    void interrupt(){
+        input->interrupt();
+    }
+};
+
+size_t Lz4Source::next(const char*& data){
+    data = output.data();
+    size_t produced = 0;
+    while (produced < output.size() && !end && !error){
+        if (inSize == 0){
+            inSize = input->next(in);
+            if (inSize == 0){
+                end = true;
+                break;
+            }
+        }
+        size_t outSize = output.size() - produced;
+        size_t consumed = inSize;
+        if (LZ4F_isError(LZ4F_decompress(context, output.data() + produced, &outSize, in, &consumed, NULL)))
+            error = true;
+        produced += outSize;
+        in += consumed;
+        inSize -= consumed;
+    }
+    return produced;
+}
+#endif
+
+/**
+ * runs another source on a helper thread that fills a bounded queue of blocks ahead of the reader,
+ * so decoding the trace overlaps with simulating it
+ */
+class ThreadedSource : public BlockSource{
+    BlockSource* input;
+    vector<vector<char> > blocks;
+    vector<size_t> sizes;
+    size_t head;        // next block to hand to the reader
+    size_t count;       // blocks filled and not yet released by the reader
+    bool borrowed;      // the reader still uses the block before head
+    bool done;
+    bool stop;
+    atomic<bool> error;     // set by the helper thread when the input fails
+    mutex lock;
+    condition_variable filled;
+    condition_variable released;
+    thread worker;
+
+    void produce();
+public:
+    explicit ThreadedSource(BlockSource* input) : input(input), blocks(TRACE_QUEUE_BLOCKS),
+                                                  sizes(TRACE_QUEUE_BLOCKS, 0), head(0), count(0),
+                                                  borrowed(false), done(false), stop(false), error(false){
+        worker = thread(&ThreadedSource::produce, this);
+    }
+    ~ThreadedSource();
+    size_t next(const char*& data);
+    bool failed() const{
+        return error;
+    }
+    void interrupt(){
+        input->interrupt();
+    }
+};
+
+/**
+ * helper thread: decodes blocks into the free slots of the queue until the input ends
+ */
+void ThreadedSource::produce(){
+    size_t tail = 0;
+    while (true){
+        {
+            unique_lock<mutex> guard(lock);
+            released.wait(guard, [this]{ return stop || count < blocks.size(); });
+            if (stop)
+                return;
+        }
+        // the slot at tail is owned by this thread until it is published
+        const char* data;
+        size_t size = input->next(data);
+        blocks[tail].assign(data, data + size);
+        error = input->failed();    // read on this thread only, the input is not shared
+        unique_lock<mutex> guard(lock);
+        sizes[tail] = size;
+        tail = (tail + 1) % blocks.size();
+        count++;
+        if (size == 0)
+            done = true;
+        filled.notify_one();
+        if (done)
+            return;
+    }
+}
+
+size_t ThreadedSource::next(const char*& data){
+    unique_lock<mutex> guard(lock);
+    if (borrowed){   // release the block handed out by the previous call
+        count--;
+        borrowed = false;
+        released.notify_one();
+    }
+    filled.wait(guard, [this]{ return count > 0; });
+    size_t size = sizes[head];
+    if (size == 0)
+        return 0;   // the end marker stays queued, so later calls return the end again
+    data = blocks[head].data();
+    head = (head + 1) % blocks.size();
+    borrowed = true;
+    return size;
+}
+
+ThreadedSource::~ThreadedSource(){
+    {
+        unique_lock<mutex> guard(lock);
+        stop = true;
+        released.notify_one();
+    }
+    input->interrupt();     // the helper thread may be blocked reading a producer that is still running
+    worker.join();
+    delete input;
+}
+
+
+TraceReader::~TraceReader(){
+    delete source;
+}
+
+bool TraceReader::failed() const{
+    return source->failed();
+}
+
+/**
+ * connects to a trace producer listening on a local stream socket
+ * @param path socket file
+ * @return the connected socket, -1 on failure
+ */
+static int connectTraceSocket(const char* path){
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path))
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0){
+        close(fd);
+        return -1;
+    }
+    int size = TRACE_BLOCK_SIZE;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    return fd;
+}
+
+/**
+ * opens a trace, detecting a compressed trace from its magic bytes. "-" reads the trace from the standard input,
+ * and a named pipe or a UNIX socket is read while the producer writes it. a trace that is produced live is read
+ * by a helper thread with blocking reads, so a slow simulation makes the producer wait instead of losing records.
+ * @param path trace file, named pipe, UNIX socket or "-"
+ * @param error set to a description of the problem when NULL is returned
+ * @return a reader of the trace, or NULL if it cannot be read
+ */
+TraceReader* TraceReader::open(const char* path, string& error){
+    int fd;
+    bool live = true;
+    struct stat info;
+    if (strcmp(path, "-") == 0)
+        fd = dup(STDIN_FILENO);
+    else if (stat(path, &info) == 0 && S_ISSOCK(info.st_mode)){
+        fd = connectTraceSocket(path);
+        if (fd < 0){
+            error = string("Cannot connect to ") + path;
+            return NULL;
+        }
+    }
+    else {
+        fd = ::open(path, O_RDONLY);
+        live = fd >= 0 && fstat(fd, &info) == 0 && S_ISFIFO(info.st_mode);
+    }
+    if (fd < 0){
+        error = "File not found";
+        return NULL;
+    }
+#ifdef F_SETPIPE_SZ
+    if (live)
+        fcntl(fd, F_SETPIPE_SZ, (int)TRACE_BLOCK_SIZE);   // fewer, larger reads, fails harmlessly on non pipes
+#endif
+    unsigned char magic[4] = {0, 0, 0, 0};
+    size_t size = 0;
+    while (size < sizeof(magic)){
+        ssize_t got = read(fd, magic + size, sizeof(magic) - size);
+        if (got <= 0)
+            break;
+        size += got;
+    }
+    BlockSource* raw = new FileSource(fd, (const char*)magic, size);
+    const char* format = NULL;
+    BlockSource* decoder = NULL;
+    if (size >= 2 && magic[0] == 0x1f && magic[1] == 0x8b){
+        format = "gzip";
+#ifdef HAVE_ZLIB
+        decoder = new GzipSource(raw);
+#endif
+    }
+    else if (size >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd){
+        format = "zstd";
+#ifdef HAVE_ZSTD
+        decoder = new ZstdSource(raw);
+#endif
+    }
+    else if (size >= 4 && magic[0] == 0x04 && magic[1] == 0x22 && magic[2] == 0x4d && magic[3] == 0x18){
+        format = "lz4";
+#ifdef HAVE_LZ4
+        decoder = new Lz4Source(raw);
+#endif
+    }
+    if (format == NULL)
+        return new TraceReader(live ? new ThreadedSource(raw) : raw);
+    if (decoder == NULL){
+        delete raw;
+        error = string("Trace is ") + format + " compressed but cacheSim was built without " + format + " support";
+        return NULL;
+    }
+    return new TraceReader(new ThreadedSource(decoder));
+}
+
+/**
+ * finds the next line of the trace
+ * @param line set to the first character of the line
+ * @param lineEnd set past the last character of the line
+ * @return false at the end of the trace
+ */
+bool TraceReader::nextLine(const char*& line, const char*& lineEnd){
+    carry.clear();
+    while (true){
+        if (position == end){
+            if (finished)
+                break;
+            const char* block;
+            size_t size = source->next(block);
+            if (size == 0){
+                finished = true;
+                break;
+            }
+            position = block;
+            end = block + size;
+        }
+        const char* newline = (const char*)memchr(position, '\n', end - position);
+        if (newline != NULL && carry.empty()){
+            line = position;
+            lineEnd = newline;
+            position = newline + 1;
+            return true;
+        }
+        if (newline != NULL){
+            carry.append(position, newline);
+            position = newline + 1;
+            break;
+        }
+        carry.append(position, end);
+        position = end;
+    }
+    if (carry.empty() || source->failed())
+        return false;   // no last line without a newline, or one cut short by a read that failed
+    line = carry.data();
+    lineEnd = carry.data() + carry.size();
+    return true;
+}
+
+/**
+ * reads the next access of the trace, a line of the form "<operation> 0x<address> [0x<pc>] [@<cycle> | +<gap>]"
+ */
+TRACE_STATUS TraceReader::next(TraceRecord& record){
+    const char* line;
+    const char* lineEnd;
+    if (!nextLine(line, lineEnd))
+        return TRACE_END;
+    while (line < lineEnd && isspace(*line))
+        line++;
+    if (line == lineEnd)
+        return TRACE_FORMAT_ERROR;
+    record.operation = *line++;
+    while (line < lineEnd && isspace(*line))
+        line++;
+    const char* address = line;
+    while (line < lineEnd && !isspace(*line))
+        line++;
+    if (line - address < 2)
+        return TRACE_FORMAT_ERROR;
+    // the "0x" prefix is skipped, the address ends at the whitespace or newline after it
+    record.address = line - address > 2 ? strtoull(address + 2, NULL, 16) : 0;
+    // optional columns after the address: a hexadecimal one is the PC of the access, and the issue time is
+    // either an absolute cycle or a gap after the previous record
+    record.pc = 0;
+    record.timeKind = NO_TIME;
+    record.time = 0;
+    while (line < lineEnd){
+        while (line < lineEnd && isspace(*line))
+            line++;
+        const char* column = line;
+        while (line < lineEnd && !isspace(*line))
+            line++;
+        if (line - column > 2 && column[0] == '0' && (column[1] == 'x' || column[1] == 'X'))
+            record.pc = strtoull(column + 2, NULL, 16);
+        else if (line - column > 1 && (column[0] == '@' || column[0] == '+')){
+            record.timeKind = column[0] == '@' ? AT_CYCLE : AFTER_GAP;
+            record.time = strtoull(column + 1, NULL, 10);
+        }
+    }
+    return TRACE_RECORD;
+}
+
+/**
+ * parses a whole trace into memory, so several runs can share it
+ * @param path trace file
+ * @param records filled with the records of the trace
+ * @param end set to TRACE_END, or to TRACE_FORMAT_ERROR if the trace stops at a bad line
+ * @param error set to a description of the problem when false is returned
+ * @return false if the trace cannot be read
+ */
+bool TraceReader::readAll(const char* path, vector<TraceRecord>& records, TRACE_STATUS& end, string& error){
+    TraceReader* reader = open(path, error);
+    if (reader == NULL)
+        return false;
+    TraceRecord record;
+    while ((end = reader->next(record)) == TRACE_RECORD)
+        records.push_back(record);
+    bool ok = !reader->failed();
+    if (!ok)
+        error = "Error reading the trace";
+    delete reader;
+    return ok;
+}
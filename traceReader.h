@@ -0,0 +1,87 @@
+//
+// Streaming trace input: plain or compressed (gzip / zstd / lz4) traces, parsed in place block by block.
+//
+
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+class BlockSource;
+
+enum TRACE_STATUS {TRACE_RECORD, TRACE_END, TRACE_FORMAT_ERROR};
+enum TRACE_TIME {NO_TIME, AT_CYCLE, AFTER_GAP};
+
+/**
+ * a single access of the trace
+ */
+struct TraceRecord{
+    char operation;
+    uint64_t address;
+    uint64_t pc;        // instruction address, 0 when the trace has no PC column
+    TRACE_TIME timeKind;
+    uint64_t time;      // issue cycle ("@<cycle>") or cycles since the previous record ("+<gap>")
+};
+
+/**
+ * a sequence of trace records
+ */
+class TraceSource{
+public:
+    virtual ~TraceSource(){}
+    /**
+     * @param record filled with the next access
+     * @return TRACE_RECORD if a record was read, TRACE_END at the end of the trace, TRACE_FORMAT_ERROR for a bad line
+     */
+    virtual TRACE_STATUS next(TraceRecord& record) = 0;
+    /**
+     * @return true if the trace could not be read or decoded
+     */
+    virtual bool failed() const{
+        return false;
+    }
+};
+
+/**
+ * splits the blocks of a source into lines and parses them in place. only a line that crosses a block boundary
+ * is copied, into a buffer that is reused for the whole trace.
+ */
+class TraceReader : public TraceSource{
+    BlockSource* source;
+    const char* position;
+    const char* end;
+    string carry;
+    bool finished;
+
+    bool nextLine(const char*& line, const char*& lineEnd);
+public:
+    explicit TraceReader(BlockSource* source) : source(source), position(NULL), end(NULL), finished(false){}
+    ~TraceReader();
+    static TraceReader* open(const char* path, string& error);
+    TRACE_STATUS next(TraceRecord& record);
+    static bool readAll(const char* path, vector<TraceRecord>& records, TRACE_STATUS& end, string& error);
+    bool failed() const;
+};
+
+/**
+ * replays a trace that was parsed into memory, the records are shared and never copied
+ */
+class RecordedTrace : public TraceSource{
+    const vector<TraceRecord>& records;
+    const TRACE_STATUS end;
+    size_t position;
+public:
+    RecordedTrace(const vector<TraceRecord>& records, TRACE_STATUS end) : records(records), end(end), position(0){}
+    TRACE_STATUS next(TraceRecord& record){
+        if (position == records.size())
+            return end;
+        record = records[position++];
+        return TRACE_RECORD;
+    }
+};
+
+#endif // TRACE_READER_H
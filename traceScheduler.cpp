@@ -0,0 +1,100 @@
+//
+// Co-scheduling of several traces: their records interleaved into one stream, each tagged with its trace.
+//
+
+#include "traceScheduler.h"
+
+/**
+ * @param sources traces to interleave, in the order of their numbers
+ * @param policy how the next trace is chosen
+ * @param weights consecutive records of every trace in a weighted round, ignored by the other policies
+ */
+TraceScheduler::TraceScheduler(const vector<TraceSource*>& sources, SCHEDULE policy,
+                               const vector<unsigned int>& weights) :
+        sources(sources),
+        policy(policy),
+        weights(policy == WEIGHTED ? weights : vector<unsigned int>(sources.size(), 1)),
+        pending(sources.size()),
+        loaded(sources.size(), false),
+        status(sources.size(), TRACE_RECORD),
+        clocks(sources.size(), 0),
+        turn(0),
+        served(0),
+        last(0){}
+
+/**
+ * reads the next record of a trace unless one is already waiting
+ * @param trace number of the trace
+ * @return TRACE_RECORD if a record is waiting, or how the trace ended
+ */
+TRACE_STATUS TraceScheduler::refill(unsigned int trace){
+    if (loaded[trace] || status[trace] != TRACE_RECORD)
+        return status[trace];
+    status[trace] = sources[trace]->next(pending[trace]);
+    if (status[trace] != TRACE_RECORD)
+        return status[trace];
+    loaded[trace] = true;
+    if (pending[trace].timeKind == AT_CYCLE)
+        clocks[trace] = pending[trace].time;
+    else if (pending[trace].timeKind == AFTER_GAP)
+        clocks[trace] += pending[trace].time;
+    else
+        clocks[trace]++;
+    return TRACE_RECORD;
+}
+
+/**
+ * @param record filled with the next access of the chosen trace
+ * @return TRACE_RECORD if a record was read, TRACE_END once every trace ended, TRACE_FORMAT_ERROR for a bad line
+ */
+TRACE_STATUS TraceScheduler::next(TraceRecord& record){
+    unsigned int count = sources.size(), trace = count;
+    if (policy == BY_TIMESTAMP){
+        for (unsigned int i = 0; i < count; i++){
+            TRACE_STATUS got = refill(i);
+            if (got == TRACE_FORMAT_ERROR)
+                return got;
+            if (got == TRACE_RECORD && (trace == count || clocks[i] < clocks[trace]))
+                trace = i;
+        }
+    }
+    else {
+        // every trace is tried once, starting with the one whose turn it is
+        for (unsigned int tried = 0; tried < count && trace == count; tried++){
+            if (served >= weights[turn]){
+                turn = (turn + 1) % count;
+                served = 0;
+            }
+            TRACE_STATUS got = refill(turn);
+            if (got == TRACE_FORMAT_ERROR)
+                return got;
+            if (got == TRACE_RECORD){
+                trace = turn;
+                served++;
+            }
+            else
+                served = weights[turn];
+        }
+    }
+    if (trace == count)
+        return TRACE_END;
+    record = pending[trace];
+    if (record.timeKind != NO_TIME){
+        record.timeKind = AT_CYCLE;
+        record.time = clocks[trace];
+    }
+    loaded[trace] = false;
+    last = trace;
+    return TRACE_RECORD;
+}
+
+/**
+ * @return true if any of the traces could not be read or decoded
+ */
+bool TraceScheduler::failed() const{
+    for (unsigned int i = 0; i < sources.size(); i++){
+        if (sources[i]->failed())
+            return true;
+    }
+    return false;
+}
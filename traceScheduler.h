@@ -0,0 +1,49 @@
+//
+// Co-scheduling of several traces: their records interleaved into one stream, each tagged with its trace.
+//
+
+#ifndef TRACE_SCHEDULER_H
+#define TRACE_SCHEDULER_H
+
+#include <vector>
+#include <stdint.h>
+#include "traceReader.h"
+
+using namespace std;
+
+enum SCHEDULE {ROUND_ROBIN, BY_TIMESTAMP, WEIGHTED};
+
+/**
+ * interleaves traces that are read at the same time, one record ahead at most, so none of them is loaded whole.
+ * round robin takes a record of every trace in turn, weighted takes as many consecutive records of a trace as its
+ * weight, and by timestamp takes the record that issues first, ties going to the lower trace.
+ * every trace keeps its own clock: "@<cycle>" sets it, "+<gap>" advances it and an untimed record advances it by
+ * one, and timed records come out as "@<cycle>" of their trace clock so they stay in order in the merged stream.
+ * a trace that ends drops out, the stream ends with the last trace, or at the first line one of them cannot parse.
+ */
+class TraceScheduler : public TraceSource{
+    const vector<TraceSource*> sources;     // not owned
+    const SCHEDULE policy;
+    const vector<unsigned int> weights;
+    vector<TraceRecord> pending;
+    vector<bool> loaded;
+    vector<TRACE_STATUS> status;
+    vector<uint64_t> clocks;
+    unsigned int turn;
+    unsigned int served;        // records taken from the trace whose turn it is
+    unsigned int last;
+
+    TRACE_STATUS refill(unsigned int trace);
+public:
+    TraceScheduler(const vector<TraceSource*>& sources, SCHEDULE policy, const vector<unsigned int>& weights);
+    TRACE_STATUS next(TraceRecord& record);
+    bool failed() const;
+    /**
+     * @return the trace the last record came from
+     */
+    unsigned int current() const{
+        return last;
+    }
+};
+
+#endif // TRACE_SCHEDULER_H
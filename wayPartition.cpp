@@ -0,0 +1,74 @@
+//
+// Way partitioning of L2 in the manner of cache allocation technology (CAT): a way mask per requestor.
+//
+
+#include "wayPartition.h"
+
+/**
+ * @param schedule masks of every requestor, one partitioning per interval, a mask has a bit per way
+ * @param interval accesses between repartitionings, 0 keeps the first partitioning
+ * @param ways ways of every set of L2
+ * @param capacity lines of L2
+ */
+WayPartition::WayPartition(const vector<vector<uint64_t> >& schedule, unsigned long long interval, unsigned int ways,
+                           unsigned long long capacity) :
+        schedule(schedule),
+        interval(interval),
+        allWays(ways >= 64 ? ~0ull : (1ull << ways) - 1),
+        capacity(capacity),
+        phase(0),
+        accesses(0),
+        lines(schedule[0].size(), 0),
+        lineSum(schedule[0].size(), 0),
+        changedAt(schedule[0].size(), 0),
+        repartitions(0){}
+
+/**
+ * @param schedule masks of every requestor, one partitioning per interval
+ * @param ways ways of every set of L2
+ * @return true if some mask leaves out a way, false when the partitions cannot change what L2 holds
+ */
+bool WayPartition::restricts(const vector<vector<uint64_t> >& schedule, unsigned int ways){
+    uint64_t allWays = ways >= 64 ? ~0ull : (1ull << ways) - 1;
+    for (unsigned int i = 0; i < schedule.size(); i++){
+        for (unsigned int requestor = 0; requestor < schedule[i].size(); requestor++){
+            if (schedule[i][requestor] != allWays)
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * adds the lines of requestor to its occupancy sum for every access since they last changed, before they change
+ */
+void WayPartition::count(unsigned int requestor){
+    lineSum[requestor] += lines[requestor] * (accesses - changedAt[requestor]);
+    changedAt[requestor] = accesses;
+}
+
+/**
+ * counts an access and moves to the next partitioning at an interval boundary, the occupancy is summed when it
+ * changes
+ */
+void WayPartition::access(){
+    accesses++;
+    if (interval && accesses % interval == 0 && phase + 1 < schedule.size()){
+        phase++;
+        repartitions++;
+    }
+}
+
+/**
+ * prints the mask in force and the occupancy of every requestor, as a share of the lines of L2
+ * @param out stream to print to
+ */
+void WayPartition::print(FILE* out) const{
+    fprintf(out, "Partitions repartitions=%u\n", repartitions);
+    for (unsigned int requestor = 0; requestor < lines.size(); requestor++){
+        unsigned long long sum = lineSum[requestor] + lines[requestor] * (accesses - changedAt[requestor]);
+        fprintf(out, "Partition %u mask=0x%llx lines=%llu share=%.03f avgShare=%.03f\n", requestor,
+                (unsigned long long)maskOf(requestor), lines[requestor], double(lines[requestor]) / capacity,
+                accesses ? double(sum) / accesses / capacity : 0.0);
+    }
+}
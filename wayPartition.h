@@ -0,0 +1,67 @@
+//
+// Way partitioning of L2 in the manner of cache allocation technology (CAT): a way mask per requestor.
+//
+
+#ifndef WAY_PARTITION_H
+#define WAY_PARTITION_H
+
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ * the ways of L2 every requestor (the core of a co-scheduled trace) may fill, and how many lines each of them owns.
+ * a fill only replaces a line in an allowed way, while hits and the lines already in a way stay untouched when the
+ * masks change. the masks come from a schedule of partitionings, the next one taking over every interval accesses
+ * until the last one stays.
+ */
+class WayPartition{
+    const vector<vector<uint64_t> > schedule;   // per interval, per requestor
+    const unsigned long long interval;          // accesses between repartitionings, 0 keeps the first one
+    const uint64_t allWays;
+    const unsigned long long capacity;          // lines of L2
+    unsigned int phase;
+    unsigned long long accesses;
+    vector<unsigned long long> lines;       // per requestor, lines it filled that are still in L2
+    vector<unsigned long long> lineSum;     // per requestor, lines summed over the accesses up to its last change
+    vector<unsigned long long> changedAt;   // per requestor, accesses at the last change of its lines
+
+    void count(unsigned int requestor);
+public:
+    unsigned int repartitions;
+    WayPartition(const vector<vector<uint64_t> >& schedule, unsigned long long interval, unsigned int ways,
+                 unsigned long long capacity);
+    /**
+     * @return the ways requestor may fill
+     */
+    uint64_t maskOf(unsigned int requestor) const{
+        return schedule[phase][requestor];
+    }
+    /**
+     * @return true if requestor may fill every way, which replaces the LRU line of the set as without partitions
+     */
+    bool unrestricted(unsigned int requestor) const{
+        return maskOf(requestor) == allWays;
+    }
+    /**
+     * counts a line requestor filled
+     */
+    void fill(unsigned int requestor){
+        count(requestor);
+        lines[requestor]++;
+    }
+    /**
+     * counts the eviction of a line requestor filled
+     */
+    void evict(unsigned int requestor){
+        count(requestor);
+        lines[requestor]--;
+    }
+    void access();
+    void print(FILE* out) const;
+    static bool restricts(const vector<vector<uint64_t> >& schedule, unsigned int ways);
+};
+
+#endif // WAY_PARTITION_H
@@ -0,0 +1,68 @@
+//
+// Coalescing write buffer between a write-through L1 and L2.
+//
+
+#include "writeBuffer.h"
+
+/**
+ * @param capacity entries, at most WRITE_BUFFER_MAX
+ * @param drainCyc cycles to write an entry to L2
+ */
+WriteBuffer::WriteBuffer(unsigned int capacity, unsigned int drainCyc) :
+        capacity(capacity < 1 ? 1 : capacity > WRITE_BUFFER_MAX ? WRITE_BUFFER_MAX : capacity),
+        drainCyc(drainCyc),
+        head(0),
+        count(0),
+        headDone(0),
+        now(0),
+        writes(0),
+        coalesced(0),
+        drained(0),
+        stallCycles(0),
+        occupancy(0),
+        maxOccupancy(0){}
+
+/**
+ * retires the entries that are in L2 by a cycle, each one starting as soon as the previous one is done
+ * @param until cycle to drain up to
+ */
+void WriteBuffer::drain(unsigned long long until){
+    while (count > 0 && headDone <= until){
+        head = (head + 1) % capacity;
+        count--;
+        drained++;
+        if (count > 0)
+            headDone += drainCyc;
+    }
+}
+
+/**
+ * buffers a store
+ * @param block block number of the store
+ * @return the cycles the store stalled for a free entry
+ */
+unsigned long long WriteBuffer::write(uint64_t block){
+    writes++;
+    drain(now);
+    occupancy += count;
+    if (count > maxOccupancy)
+        maxOccupancy = count;
+    // the head is already on its way to L2, the entries behind it can still take the store
+    for (unsigned int i = 1; i < count; i++){
+        if (blocks[(head + i) % capacity] == block){
+            coalesced++;
+            return 0;
+        }
+    }
+    unsigned long long stall = 0;
+    if (count == capacity){
+        stall = headDone - now;
+        stallCycles += stall;
+        drain(headDone);
+    }
+    if (count == 0)
+        headDone = now + stall + drainCyc;
+    blocks[(head + count) % capacity] = block;
+    count++;
+    return stall;
+}
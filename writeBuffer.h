@@ -0,0 +1,38 @@
+//
+// Coalescing write buffer between a write-through L1 and L2.
+//
+
+#ifndef WRITE_BUFFER_H
+#define WRITE_BUFFER_H
+
+#include <stdint.h>
+
+static const unsigned int WRITE_BUFFER_MAX = 64;
+
+/**
+ * holds the stores of a write-through L1 until they drain to L2, one entry every drainCyc cycles, oldest first.
+ * a store to a block that is already waiting merges into its entry, and a store that finds the buffer full stalls
+ * until the oldest entry has drained. stores arrive at the cycle in now, set by the owner of the clock.
+ */
+class WriteBuffer{
+    uint64_t blocks[WRITE_BUFFER_MAX];  // circular, head is the entry draining now
+    const unsigned int capacity;
+    const unsigned int drainCyc;
+    unsigned int head;
+    unsigned int count;
+    unsigned long long headDone;        // cycle the head entry is in L2
+
+    void drain(unsigned long long until);
+public:
+    unsigned long long now;
+    unsigned long long writes;
+    unsigned long long coalesced;       // stores merged into a waiting entry
+    unsigned long long drained;         // entries written to L2
+    unsigned long long stallCycles;
+    unsigned long long occupancy;       // sum of the entries every store found
+    unsigned int maxOccupancy;
+    WriteBuffer(unsigned int capacity, unsigned int drainCyc);
+    unsigned long long write(uint64_t block);
+};
+
+#endif // WRITE_BUFFER_H